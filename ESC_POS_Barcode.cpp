@@ -0,0 +1,120 @@
+/*------------------------------------------------------------------------
+  Code 128 encoder for ESC_POS_Printer.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Barcode.h"
+
+enum { SET_A, SET_B, SET_C };
+
+// Costs are symbol characters * 1024 + data bytes, so fewer characters
+// always win and bytes break ties.
+#define COST(chars, bytes) ((uint32_t)(chars) * 1024 + (bytes))
+#define NO_WAY             0xFFFFFFFFUL
+
+static bool inSet(uint8_t set, uint8_t c) {
+    return (set == SET_A) ? (c < 0x60) : (c >= 0x20);
+}
+
+static bool isDigit(uint8_t c) {
+    return (c >= '0') && (c <= '9');
+}
+
+// Bytes for character c in set B ('{' is sent as "{{")
+static uint8_t bytesB(uint8_t c) {
+    return (c == '{') ? 2 : 1;
+}
+
+// Cost of encoding text from i on in set, without changing sets at i,
+// given the best costs from i + 1 (next) and i + 2 (after).
+static uint32_t stayCost(const uint8_t *text, size_t len, size_t i,
+        uint8_t set, const uint32_t *next, const uint32_t *after) {
+    uint8_t  c = text[i];
+    uint32_t rest, cost;
+
+    if(set == SET_C) {
+        if((i + 1 >= len) || !isDigit(c) || !isDigit(text[i + 1])) return NO_WAY;
+        rest = after[SET_C];
+        cost = COST(1, 1);
+    } else {
+        rest = next[set];
+        if(inSet(set, c)) {
+            cost = COST(1, (set == SET_B) ? bytesB(c) : 1);
+        } else {
+            cost = COST(2, 2 + ((set == SET_A) ? bytesB(c) : 1)); // Shift
+        }
+    }
+    return (rest == NO_WAY) ? NO_WAY : rest + cost;
+}
+
+size_t encodeCode128(const uint8_t *text, size_t len, uint8_t *out,
+        size_t outSize) {
+    uint8_t  change[ESC_POS_CODE128_MAX]; // Set to change to at i, per set, 2 bits each
+    uint32_t best[3][3];                  // Best costs from i, i + 1, i + 2
+    uint32_t *cur = best[0], *next = best[1], *after = best[2];
+
+    if(!len || (len > ESC_POS_CODE128_MAX)) return 0;
+    for(size_t i = 0; i < len; i++) {
+        if(text[i] >= 0x80) return 0;
+    }
+
+    // Work back from the end: the best way to encode text from i on in
+    // each set is to stay in it, or change to another set first.
+    for(uint8_t s = 0; s < 3; s++) next[s] = after[s] = 0;
+    uint32_t stay[3];
+    for(size_t i = len; i-- > 0; ) {
+        for(uint8_t s = 0; s < 3; s++) {
+            stay[s] = stayCost(text, len, i, s, next, after);
+        }
+        change[i] = 0;
+        for(uint8_t s = 0; s < 3; s++) {
+            uint8_t to = s;
+            cur[s] = stay[s];
+            for(uint8_t t = 0; t < 3; t++) {
+                if((stay[t] != NO_WAY) && (stay[t] + COST(1, 2) < cur[s])) {
+                    cur[s] = stay[t] + COST(1, 2);
+                    to     = t;
+                }
+            }
+            change[i] |= to << (2 * s);
+        }
+        uint32_t *t = after;
+        after = next;
+        next  = cur;
+        cur   = t;
+    }
+
+    // The start character picks the set that is cheapest from the start;
+    // next now holds the costs from 0.
+    uint8_t set = SET_A;
+    for(uint8_t s = 1; s < 3; s++) {
+        if(next[s] < next[set]) set = s;
+    }
+    if((next[set] & 1023) + 2 > outSize) return 0;
+
+    size_t n = 0;
+    out[n++] = '{';
+    out[n++] = 'A' + set;
+    for(size_t i = 0; i < len; ) {
+        uint8_t to = (change[i] >> (2 * set)) & 3;
+        if(to != set) {
+            set      = to;
+            out[n++] = '{';
+            out[n++] = 'A' + set;
+        }
+        uint8_t c = text[i];
+        if(set == SET_C) {
+            out[n++] = (c - '0') * 10 + (text[i + 1] - '0');
+            i += 2;
+            continue;
+        }
+        if(!inSet(set, c)) {
+            out[n++] = '{';
+            out[n++] = 'S';
+        }
+        if(c == '{') out[n++] = '{';
+        out[n++] = c;
+        i++;
+    }
+    return n;
+}
@@ -0,0 +1,30 @@
+/*------------------------------------------------------------------------
+  Code 128 encoder for ESC_POS_Printer.
+
+  GS k function B prints Code 128 from data that names its code sets:
+  "{A", "{B" and "{C" select set A (controls and upper case), B (printable
+  ASCII) or C (digit pairs, one byte each), "{S" shifts one character
+  between A and B and "{{" is a '{'.  The encoder chooses the sets so the
+  symbol has the fewest characters, and of those the fewest data bytes.
+  Long runs of digits go in set C at half the width.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_BARCODE_H
+#define ESC_POS_BARCODE_H
+
+#include "Arduino.h"
+
+// Longest text encodeCode128() takes.  Encoding needs a byte of stack
+// per character.
+#ifndef ESC_POS_CODE128_MAX
+#define ESC_POS_CODE128_MAX 80
+#endif
+
+// Encode len characters (0x00 to 0x7F) as GS k function B data for
+// CODE128.  Returns the number of bytes stored in out, or 0 if the text
+// is too long, has other characters or the data does not fit in outSize.
+size_t
+    encodeCode128(const uint8_t *text, size_t len, uint8_t *out, size_t outSize);
+
+#endif // ESC_POS_BARCODE_H
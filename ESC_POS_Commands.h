@@ -0,0 +1,119 @@
+/*------------------------------------------------------------------------
+  Compile-time ESC/POS command sequences for ESC_POS_Printer.
+
+  Commands are types, and ESC_POS_Cat joins them into one byte array
+  stored in flash, built entirely by the compiler:
+
+    typedef ESC_POS_Cat<ESC_POS_Justify<'C'>, ESC_POS_BoldOn,
+                        ESC_POS_Size<2, 2> >::type Title;
+    printer.command<Title>();
+
+  command() sends the array in one piece and forgets the printer modes
+  the sequence changes, so later style calls are not skipped by mistake.
+  Print mode, size, line spacing and reset commands in it are followed,
+  so text wraps and feeds as it does after doubleWidthOn(), setSize(),
+  setLineHeight() or reset().  Sequences are for commands; print text
+  the usual way.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_COMMANDS_H
+#define ESC_POS_COMMANDS_H
+
+#include "ESC_POS_Printer.h"
+
+// A sequence of bytes.  Modes is a mask of the ESC_POS_Printer::MODE_*
+// settings the bytes change.
+template<uint16_t Modes, uint8_t... Bytes>
+struct ESC_POS_Seq {
+    typedef ESC_POS_Seq type;
+    enum { modes = Modes, size = sizeof...(Bytes) };
+    static const uint8_t data[sizeof...(Bytes)];
+};
+
+template<uint16_t Modes, uint8_t... Bytes>
+const uint8_t ESC_POS_Seq<Modes, Bytes...>::data[sizeof...(Bytes)] PROGMEM = {
+    Bytes...
+};
+
+// Join any number of sequences into one
+template<class... Seqs>
+struct ESC_POS_Cat;
+
+template<class Seq>
+struct ESC_POS_Cat<Seq> {
+    typedef typename Seq::type type;
+};
+
+template<uint16_t M1, uint8_t... B1, uint16_t M2, uint8_t... B2, class... Rest>
+struct ESC_POS_Cat<ESC_POS_Seq<M1, B1...>, ESC_POS_Seq<M2, B2...>, Rest...> {
+    typedef typename ESC_POS_Cat<ESC_POS_Seq<M1 | M2, B1..., B2...>, Rest...>::type type;
+};
+
+#define ESC_POS_MODE(m) (1 << ESC_POS_Printer::m)
+
+// === Commands ===
+
+// ESC @: every mode goes back to its default
+typedef ESC_POS_Seq<0xFFFF, 0x1B, '@'> ESC_POS_Reset;
+
+template<uint8_t On>
+using ESC_POS_Bold = ESC_POS_Seq<ESC_POS_MODE(MODE_BOLD), 0x1B, 'E', On>;
+typedef ESC_POS_Bold<1> ESC_POS_BoldOn;
+typedef ESC_POS_Bold<0> ESC_POS_BoldOff;
+
+// Weight 0 (off), 1 or 2
+template<uint8_t Weight>
+using ESC_POS_Underline = ESC_POS_Seq<ESC_POS_MODE(MODE_UNDERLINE), 0x1B, '-', Weight>;
+
+template<uint8_t On>
+using ESC_POS_Strike = ESC_POS_Seq<ESC_POS_MODE(MODE_STRIKE), 0x1B, 'G', On>;
+
+template<uint8_t On>
+using ESC_POS_Inverse = ESC_POS_Seq<ESC_POS_MODE(MODE_INVERSE), 0x1D, 'B', On>;
+
+template<uint8_t On>
+using ESC_POS_UpsideDown = ESC_POS_Seq<ESC_POS_MODE(MODE_UPSIDE_DOWN), 0x1B, '{', On>;
+
+// 'L', 'C' or 'R', as justify()
+template<char Where>
+using ESC_POS_Justify = ESC_POS_Seq<ESC_POS_MODE(MODE_JUSTIFY), 0x1B, 'a',
+    (Where == 'C' || Where == 'c') ? 1 : (Where == 'R' || Where == 'r') ? 2 : 0>;
+
+// ESC ! print mode bits, as setPrintMode()
+template<uint8_t Mode>
+using ESC_POS_PrintMode = ESC_POS_Seq<ESC_POS_MODE(MODE_PRINT), 0x1B, '!', Mode>;
+
+// Character width and height, each 1 to 8 times normal
+template<uint8_t Width, uint8_t Height>
+using ESC_POS_Size = ESC_POS_Seq<ESC_POS_MODE(MODE_SIZE), 0x1D, '!',
+    (((Width - 1) & 7) << 4) | ((Height - 1) & 7)>;
+
+template<uint8_t Dots>
+using ESC_POS_LineHeight = ESC_POS_Seq<ESC_POS_MODE(MODE_LINE_HEIGHT), 0x1B, '3', Dots>;
+typedef ESC_POS_Seq<ESC_POS_MODE(MODE_LINE_HEIGHT), 0x1B, '2'> ESC_POS_DefaultLineHeight;
+
+template<uint8_t Dots>
+using ESC_POS_CharSpacing = ESC_POS_Seq<ESC_POS_MODE(MODE_CHAR_SPACING), 0x1B, ' ', Dots>;
+
+template<uint8_t Charset>
+using ESC_POS_Charset = ESC_POS_Seq<ESC_POS_MODE(MODE_CHARSET), 0x1B, 'R', Charset>;
+
+template<uint8_t CodePage>
+using ESC_POS_CodePage = ESC_POS_Seq<ESC_POS_MODE(MODE_CODE_PAGE), 0x1B, 't', CodePage>;
+
+// Print in one direction only, for better aligned graphics
+template<uint8_t On>
+using ESC_POS_Unidirectional = ESC_POS_Seq<0, 0x1B, 'U', On>;
+
+template<uint8_t Lines>
+using ESC_POS_Feed = ESC_POS_Seq<0, 0x1B, 'd', Lines>;
+
+template<uint8_t Dots>
+using ESC_POS_FeedRows = ESC_POS_Seq<0, 0x1B, 'J', Dots>;
+
+// Feed to the cutter and cut, leaving a strip uncut if Partial
+template<uint8_t Partial>
+using ESC_POS_Cut = ESC_POS_Seq<0, 0x1D, 'V', Partial ? 66 : 65, 0>;
+
+#endif // ESC_POS_COMMANDS_H
@@ -0,0 +1,165 @@
+/*------------------------------------------------------------------------
+  Jobs shared among several printers.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Dispatcher.h"
+
+// Status that stops a printer taking or finishing a job
+#define STATUS_TROUBLE \
+    (STATUS_OFFLINE | STATUS_COVER_OPEN | STATUS_PAPER_OUT | STATUS_ERROR)
+
+ESC_POS_Dispatcher::ESC_POS_Dispatcher() :
+    printerCount(0), lastId(0), submitted(0), freed(0) {
+    for(uint8_t i = 0; i < ESC_POS_DISPATCH_JOBS; i++) {
+        jobs[i].state = JOB_NONE;
+    }
+}
+
+bool ESC_POS_Dispatcher::addPrinter(ESC_POS_Printer &printer) {
+    if(printerCount >= ESC_POS_DISPATCH_PRINTERS) return false;
+    printers[printerCount]  = &printer;
+    idleOrder[printerCount] = freed++;
+    current[printerCount++] = -1;
+    return true;
+}
+
+uint8_t ESC_POS_Dispatcher::submit(const uint8_t *data, size_t len,
+        unsigned long work) {
+    int8_t slot = -1;
+
+    // A free slot, or else the job done longest ago
+    for(uint8_t i = 0; i < ESC_POS_DISPATCH_JOBS; i++) {
+        if(jobs[i].state == JOB_NONE) {
+            slot = i;
+            break;
+        }
+        if((jobs[i].state == JOB_DONE) && ((slot < 0) ||
+                (uint16_t)(jobs[i].order - jobs[slot].order) > 0x8000)) {
+            slot = i;
+        }
+    }
+    if(slot < 0) return 0;
+
+    if(++lastId == 0) lastId = 1;
+    Job &job    = jobs[slot];
+    job.data    = data;
+    job.len     = len;
+    job.sent    = 0;
+    job.work    = work;
+    job.order   = submitted++;
+    job.id      = lastId;
+    job.state   = JOB_WAITING;
+    job.printer = -1;
+    return job.id;
+}
+
+uint8_t ESC_POS_Dispatcher::submit(ESC_POS_Receipt &receipt) {
+    receipt.stop();
+    if(!receipt.data()) return 0;
+    return submit(receipt.data(), receipt.length(), receipt.printTime());
+}
+
+uint8_t ESC_POS_Dispatcher::jobState(uint8_t id) {
+    for(uint8_t i = 0; i < ESC_POS_DISPATCH_JOBS; i++) {
+        if((jobs[i].state != JOB_NONE) && (jobs[i].id == id)) {
+            return jobs[i].state;
+        }
+    }
+    return JOB_NONE;
+}
+
+int8_t ESC_POS_Dispatcher::printerOf(uint8_t id) {
+    for(uint8_t i = 0; i < ESC_POS_DISPATCH_JOBS; i++) {
+        if((jobs[i].state != JOB_NONE) && (jobs[i].id == id)) {
+            return jobs[i].printer;
+        }
+    }
+    return -1;
+}
+
+uint8_t ESC_POS_Dispatcher::waiting() {
+    uint8_t n = 0;
+    for(uint8_t i = 0; i < ESC_POS_DISPATCH_JOBS; i++) {
+        if((jobs[i].state == JOB_WAITING) || (jobs[i].state == JOB_PRINTING)) {
+            n++;
+        }
+    }
+    return n;
+}
+
+bool ESC_POS_Dispatcher::healthy(uint8_t p) {
+    return !(printers[p]->status() & STATUS_TROUBLE);
+}
+
+// Give waiting jobs, oldest first, to idle healthy printers, the one
+// idle longest first.  Its last job has been sent, but may still be
+// printing; the printer idle longest has had most time to finish.
+void ESC_POS_Dispatcher::assign() {
+    for(;;) {
+        int8_t j = -1, p = -1;
+
+        for(uint8_t i = 0; i < ESC_POS_DISPATCH_JOBS; i++) {
+            if((jobs[i].state == JOB_WAITING) && ((j < 0) ||
+                    (uint16_t)(jobs[i].order - jobs[j].order) > 0x8000)) {
+                j = i;
+            }
+        }
+        if(j < 0) return;
+        for(uint8_t i = 0; i < printerCount; i++) {
+            if((current[i] < 0) && healthy(i) && ((p < 0) ||
+                    (uint16_t)(idleOrder[i] - idleOrder[p]) > 0x8000)) {
+                p = i;
+            }
+        }
+        if(p < 0) return;
+
+        current[p]       = j;
+        jobs[j].state    = JOB_PRINTING;
+        jobs[j].sent     = 0;
+        jobs[j].printer  = p;
+    }
+}
+
+size_t ESC_POS_Dispatcher::poll() {
+    size_t sent = 0;
+
+    // Take jobs back from printers in trouble
+    for(uint8_t i = 0; i < printerCount; i++) {
+        if((current[i] >= 0) && !healthy(i)) {
+            Job &job = jobs[current[i]];
+            printers[i]->cancel();
+            job.state    = JOB_WAITING;
+            job.printer  = -1;
+            current[i]   = -1;
+            idleOrder[i] = freed++;
+        }
+    }
+
+    assign();
+
+    // Top up each printer's queue, then let it write what it can
+    for(uint8_t i = 0; i < printerCount; i++) {
+        ESC_POS_Printer &printer = *printers[i];
+        if(current[i] >= 0) {
+            Job &job = jobs[current[i]];
+            // Without a queue replay() writes straight to the stream, so
+            // a little at a time lets the other printers go on too
+            size_t room = printer.queueRoom();
+            if(room == (size_t)-1) room = ESC_POS_BUFFER_SIZE;
+            size_t n = min(job.len - job.sent, room);
+            if(n > 0) {
+                printer.replay(job.data + job.sent, n, job.sent ? 0 : job.work);
+                job.sent += n;
+            }
+        }
+        sent += printer.poll();
+        if((current[i] >= 0) && (jobs[current[i]].sent == jobs[current[i]].len) &&
+                (printer.queued() == 0)) {
+            jobs[current[i]].state = JOB_DONE;
+            current[i]   = -1;
+            idleOrder[i] = freed++;
+        }
+    }
+    return sent;
+}
@@ -0,0 +1,101 @@
+/*------------------------------------------------------------------------
+  Jobs shared among several printers.
+
+  ESC_POS_Dispatcher takes jobs as printer bytes, such as receipts
+  recorded with ESC_POS_Receipt, and prints each on one of up to
+  ESC_POS_DISPATCH_PRINTERS printers.  A printer takes one job at a time.
+  The oldest waiting job goes to the printer that has been idle longest,
+  the one most likely to have finished printing its last job, skipping
+  printers that report paper out, an open cover, an error or being
+  offline.  A printer that reports one of these mid-job has the rest of
+  the job cancelled, and the whole job is printed again elsewhere.
+  Every printer is fed from its own queue (setQueue()) a little at a
+  time in poll(), so all of them print at once; a printer without a
+  queue gets ESC_POS_BUFFER_SIZE bytes per poll().  Turn on status back
+  (setStatusBack()) for the printers to report trouble without being
+  asked.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_DISPATCHER_H
+#define ESC_POS_DISPATCHER_H
+
+#include "ESC_POS_Printer.h"
+#include "ESC_POS_Receipt.h"
+
+#ifndef ESC_POS_DISPATCH_PRINTERS
+#define ESC_POS_DISPATCH_PRINTERS 4
+#endif
+
+// Jobs held at once, waiting, printing or done
+#ifndef ESC_POS_DISPATCH_JOBS
+#define ESC_POS_DISPATCH_JOBS 8
+#endif
+
+// jobState() values
+#define JOB_NONE     0 // No such job, or forgotten to make room
+#define JOB_WAITING  1
+#define JOB_PRINTING 2
+#define JOB_DONE     3 // All sent to the printer
+
+class ESC_POS_Dispatcher {
+
+    public:
+
+        ESC_POS_Dispatcher();
+
+        // Returns false if there are already ESC_POS_DISPATCH_PRINTERS
+        bool
+            addPrinter(ESC_POS_Printer &printer);
+
+        // Queue a job of len bytes taking work microseconds to print (see
+        // endCapture()).  The bytes must stay in memory until the job is
+        // done.  Returns an id for jobState(), or 0 if there is no room or
+        // the receipt is not all in its buffer.
+        uint8_t
+            submit(const uint8_t *data, size_t len, unsigned long work=0),
+            submit(ESC_POS_Receipt &receipt),
+            jobState(uint8_t id),
+            waiting();     // Jobs not yet done
+        // The printer (by order of addPrinter()) printing job id, or -1
+        int8_t
+            printerOf(uint8_t id);
+
+        // Move jobs along; call it often, e.g. from loop().  Returns the
+        // number of bytes written to the printers.
+        size_t
+            poll();
+
+    private:
+
+        struct Job {
+            const uint8_t *data;
+            size_t         len,
+                           sent;    // Bytes passed to the printer so far
+            unsigned long  work;
+            uint16_t       order;   // Submission order, oldest first
+            uint8_t        id,
+                           state;
+            int8_t         printer;
+        };
+
+        Job
+            jobs[ESC_POS_DISPATCH_JOBS];
+        ESC_POS_Printer
+            *printers[ESC_POS_DISPATCH_PRINTERS];
+        int8_t
+            current[ESC_POS_DISPATCH_PRINTERS]; // Job printing, or -1
+        uint8_t
+            printerCount,
+            lastId;
+        uint16_t
+            submitted,
+            freed,         // Times a printer has become idle
+            idleOrder[ESC_POS_DISPATCH_PRINTERS]; // freed when it last did
+        bool
+            healthy(uint8_t p);
+        void
+            assign();
+};
+
+#endif // ESC_POS_DISPATCHER_H
@@ -0,0 +1,217 @@
+/*------------------------------------------------------------------------
+  Image sources and bit image conversion for ESC_POS_Printer.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Image.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// === Row sources ===
+
+ESC_POS_MemoryRows::ESC_POS_MemoryRows(
+        const uint8_t *bitmap, int stride, bool fromProgMem) :
+    next(bitmap), stride(stride), progMem(fromProgMem) {
+    }
+
+bool ESC_POS_MemoryRows::readRow(uint8_t *row, int nBytes) {
+    if(progMem) memcpy_P(row, next, nBytes);
+    else        memcpy(row, next, nBytes);
+    next += stride;
+    return true;
+}
+
+const uint8_t *ESC_POS_MemoryRows::takeRows(int n, int nBytes) {
+    if(progMem || (stride != nBytes)) return NULL;
+    const uint8_t *rows = next;
+    next += n * stride;
+    return rows;
+}
+
+ESC_POS_StreamRows::ESC_POS_StreamRows(Stream *s, int stride) :
+    stream(s), stride(stride) {
+    }
+
+bool ESC_POS_StreamRows::readRow(uint8_t *row, int nBytes) {
+    uint8_t skip[16];
+
+    if(stream->readBytes(row, nBytes) != (size_t)nBytes) return false;
+    for(int left = stride - nBytes; left > 0; ) {
+        int n = min(left, (int)sizeof(skip));
+        if(stream->readBytes(skip, n) != (size_t)n) return false;
+        left -= n;
+    }
+    return true;
+}
+
+// === Dithering ===
+
+// 8x8 Bayer threshold matrix, values 0 to 63
+static const uint8_t bayer[64] PROGMEM = {
+     0, 32,  8, 40,  2, 34, 10, 42,
+    48, 16, 56, 24, 50, 18, 58, 26,
+    12, 44,  4, 36, 14, 46,  6, 38,
+    60, 28, 52, 20, 62, 30, 54, 22,
+     3, 35, 11, 43,  1, 33,  9, 41,
+    51, 19, 59, 27, 49, 17, 57, 25,
+    15, 47,  7, 39, 13, 45,  5, 37,
+    63, 31, 55, 23, 61, 29, 53, 21
+};
+
+ESC_POS_Dither::ESC_POS_Dither(
+        ESC_POS_RowSource &gray, int width, uint8_t mode) :
+    gray(gray), width(min(width, ESC_POS_IMAGE_MAX_WIDTH)), y(0), mode(mode) {
+    memset(err, 0, sizeof(err));
+}
+
+bool ESC_POS_Dither::readRow(uint8_t *row, int nBytes) {
+    int dots = min(width, nBytes * 8);
+
+    if(!gray.readRow(grayRow, width)) return false;
+    memset(row, 0, nBytes);
+
+    switch(mode) {
+        case DITHER_FLOYD_STEINBERG: {
+            // err[x + 1] holds the error passed down to dot x from the row
+            // above.  It is replaced, one dot behind, by the error for the
+            // row below: a is what dot x - 1 will get, b what dot x gets.
+            // A dot's error e is within +-127, since what it is handed adds
+            // up to at most 16/16 of earlier errors, so the 9/16 of them
+            // kept in err fit in a byte.
+            int16_t right = 0, a = 0, b = 0;
+            for(int x = 0; x < width; x++) {
+                int16_t v = grayRow[x] + right + err[x + 1];
+                int16_t e;
+                if(v < 128) {
+                    if(x < dots) row[x >> 3] |= 0x80 >> (x & 7);
+                    e = v;
+                } else {
+                    e = v - 255;
+                }
+                right  = (e * 7) / 16;
+                err[x] = a + (e * 3) / 16;
+                a      = b + (e * 5) / 16;
+                b      = e / 16;
+            }
+            err[width] = a;
+            break;
+        }
+        case DITHER_ORDERED: {
+            const uint8_t *m = bayer + (y & 7) * 8;
+            for(int x = 0; x < dots; x++) {
+                if(grayRow[x] < pgm_read_byte(m + (x & 7)) * 4 + 2) {
+                    row[x >> 3] |= 0x80 >> (x & 7);
+                }
+            }
+            break;
+        }
+        default:
+            for(int x = 0; x < dots; x++) {
+                if(grayRow[x] < 128) row[x >> 3] |= 0x80 >> (x & 7);
+            }
+            break;
+    }
+    y++;
+    return true;
+}
+
+// === Row to column conversion ===
+
+// Transpose an 8 x 8 block of dots: in[i * inStride] is row i,
+// out[k * outStride] receives column k.  Most significant bit is the
+// leftmost dot of a row and the top dot of a column.  Word-parallel
+// version from Hacker's Delight (transpose8rS32).
+static void transpose8(const uint8_t *in, int inStride,
+        uint8_t *out, int outStride) {
+    uint32_t x, y, t;
+
+    x = ((uint32_t)in[0]            << 24) | ((uint32_t)in[inStride]     << 16) |
+        ((uint32_t)in[2 * inStride] <<  8) |  (uint32_t)in[3 * inStride];
+    y = ((uint32_t)in[4 * inStride] << 24) | ((uint32_t)in[5 * inStride] << 16) |
+        ((uint32_t)in[6 * inStride] <<  8) |  (uint32_t)in[7 * inStride];
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000CCCC; x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC; y = y ^ t ^ (t << 14);
+
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    out[0]             = x >> 24; out[outStride]     = x >> 16;
+    out[2 * outStride] = x >>  8; out[3 * outStride] = x;
+    out[4 * outStride] = y >> 24; out[5 * outStride] = y >> 16;
+    out[6 * outStride] = y >>  8; out[7 * outStride] = y;
+}
+
+#if defined(__SSE2__)
+// Transpose 8 rows of 16 bytes (128 columns) at once.  The rows are
+// interleaved so each 64-bit lane holds one byte of all 8 rows with row 0
+// in the top byte; movemask then picks one column out of two lanes per
+// step.
+static void transpose8x16(const uint8_t *in, int inStride,
+        uint8_t *out, int outStride) {
+    __m128i r[8];
+    for(int i = 0; i < 8; i++) {
+        r[i] = _mm_loadu_si128((const __m128i *)(in + (7 - i) * inStride));
+    }
+
+    for(int half = 0; half < 2; half++) {
+        __m128i p01, p23, p45, p67, q0, q1, lane[4];
+        if(half == 0) {
+            p01 = _mm_unpacklo_epi8(r[0], r[1]);
+            p23 = _mm_unpacklo_epi8(r[2], r[3]);
+            p45 = _mm_unpacklo_epi8(r[4], r[5]);
+            p67 = _mm_unpacklo_epi8(r[6], r[7]);
+        } else {
+            p01 = _mm_unpackhi_epi8(r[0], r[1]);
+            p23 = _mm_unpackhi_epi8(r[2], r[3]);
+            p45 = _mm_unpackhi_epi8(r[4], r[5]);
+            p67 = _mm_unpackhi_epi8(r[6], r[7]);
+        }
+        q0 = _mm_unpacklo_epi16(p01, p23);
+        q1 = _mm_unpacklo_epi16(p45, p67);
+        lane[0] = _mm_unpacklo_epi32(q0, q1);   // Bytes 0 and 1
+        lane[1] = _mm_unpackhi_epi32(q0, q1);   // Bytes 2 and 3
+        q0 = _mm_unpackhi_epi16(p01, p23);
+        q1 = _mm_unpackhi_epi16(p45, p67);
+        lane[2] = _mm_unpacklo_epi32(q0, q1);   // Bytes 4 and 5
+        lane[3] = _mm_unpackhi_epi32(q0, q1);   // Bytes 6 and 7
+
+        for(int l = 0; l < 4; l++) {
+            int byte = half * 8 + l * 2;
+            uint8_t *o = out + byte * 8 * outStride;
+            __m128i v = lane[l];
+            for(int k = 0; k < 8; k++) {
+                int bits = _mm_movemask_epi8(v);
+                o[k * outStride]       = bits;
+                o[(k + 8) * outStride] = bits >> 8;
+                v = _mm_add_epi8(v, v);
+            }
+        }
+    }
+}
+#endif
+
+void ESC_POS_bandToColumns(const uint8_t *rows, int rowBytes, int bandHeight,
+        int firstByte, int nBytes, uint8_t *out) {
+    int groups = bandHeight / 8; // Bytes per column
+
+    for(int g = 0; g < groups; g++) {
+        const uint8_t *in = rows + g * 8 * rowBytes + firstByte;
+        uint8_t *o = out + g;
+        int b = 0;
+#if defined(__SSE2__)
+        for(; b + 16 <= nBytes; b += 16) {
+            transpose8x16(in + b, rowBytes, o + b * 8 * groups, groups);
+        }
+#endif
+        for(; b < nBytes; b++) {
+            transpose8(in + b, rowBytes, o + b * 8 * groups, groups);
+        }
+    }
+}
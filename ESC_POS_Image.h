@@ -0,0 +1,135 @@
+/*------------------------------------------------------------------------
+  Image sources and bit image conversion for ESC_POS_Printer.
+
+  Images are handed to the printer one row at a time by an
+  ESC_POS_RowSource.  Rows are 1 bit per dot, most significant bit
+  leftmost, 1 is black, padded to a whole number of bytes -- the same
+  layout as the row-major printBitmap() calls.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_IMAGE_H
+#define ESC_POS_IMAGE_H
+
+#include "Arduino.h"
+#include "ESC_POS_Profile.h"
+
+// Widest image, in dots, that printImage() will send; by default the
+// width of 80 mm paper, or 58 mm paper on AVR, or the paper of a fixed
+// profile.  Images wider than this or the printer's paper are clipped on
+// the right.  This also sizes the band buffer on the stack (24 rows of
+// ESC_POS_IMAGE_MAX_WIDTH / 8 bytes).
+#ifndef ESC_POS_IMAGE_MAX_WIDTH
+#if ESC_POS_PROFILE_FIXED
+#define ESC_POS_IMAGE_MAX_WIDTH ((int)ESC_POS_PROFILE.dots)
+#elif defined(__AVR__)
+#define ESC_POS_IMAGE_MAX_WIDTH 384
+#else
+#define ESC_POS_IMAGE_MAX_WIDTH 576
+#endif
+#endif
+
+// Base class for anything that can produce image rows.
+class ESC_POS_RowSource {
+
+    public:
+
+        // Store the first nBytes bytes of the next row in row and skip
+        // the rest of it.  Return false if there is no row to be had.
+        virtual bool
+            readRow(uint8_t *row, int nBytes) = 0;
+
+        // If the next n rows of nBytes bytes each already sit one after
+        // another in RAM, skip them and return where they are, so they
+        // can be sent without copying.  Otherwise return NULL.
+        virtual const uint8_t *
+            takeRows(int /* n */, int /* nBytes */) { return NULL; }
+};
+
+// Rows from an image in RAM or PROGMEM, stride bytes per row.
+class ESC_POS_MemoryRows : public ESC_POS_RowSource {
+
+    public:
+
+        ESC_POS_MemoryRows(const uint8_t *bitmap, int stride,
+                bool fromProgMem=false);
+
+        bool
+            readRow(uint8_t *row, int nBytes);
+        const uint8_t
+            *takeRows(int n, int nBytes);
+
+    private:
+
+        const uint8_t
+            *next;
+        int
+            stride;
+        bool
+            progMem;
+};
+
+// Rows read from a Stream, stride bytes per row.  Reads wait at most the
+// Stream's timeout (see Stream::setTimeout()).
+class ESC_POS_StreamRows : public ESC_POS_RowSource {
+
+    public:
+
+        ESC_POS_StreamRows(Stream *s, int stride);
+
+        bool
+            readRow(uint8_t *row, int nBytes);
+
+    private:
+
+        Stream
+            *stream;
+        int
+            stride;
+};
+
+// Ways of turning grayscale into black and white dots
+#define DITHER_THRESHOLD        0 // Black below 50% gray
+#define DITHER_ORDERED          1 // 8x8 Bayer matrix, no memory needed
+#define DITHER_FLOYD_STEINBERG  2 // Error diffusion, best for photos
+
+// Rows made by dithering a grayscale image.  gray supplies rows of one
+// byte per dot, 0 is black and 255 is white; each call reads one gray row
+// and returns it as 1-bit dots.  Memory use is one gray row plus one row
+// of error terms, whatever the height of the image: 2 *
+// ESC_POS_IMAGE_MAX_WIDTH + 2 bytes (770 on AVR), on the stack when
+// printGrayscale() makes one, besides printImage()'s band buffer.  On a
+// board with 2 KB of RAM, define ESC_POS_IMAGE_MAX_WIDTH no wider than
+// the images printed.
+class ESC_POS_Dither : public ESC_POS_RowSource {
+
+    public:
+
+        ESC_POS_Dither(ESC_POS_RowSource &gray, int width,
+                uint8_t mode=DITHER_FLOYD_STEINBERG);
+
+        bool
+            readRow(uint8_t *row, int nBytes);
+
+    private:
+
+        ESC_POS_RowSource
+            &gray;
+        int
+            width,
+            y;
+        uint8_t
+            mode,
+            grayRow[ESC_POS_IMAGE_MAX_WIDTH];
+        int8_t
+            err[ESC_POS_IMAGE_MAX_WIDTH + 2]; // Error carried to next row
+};
+
+// Turn a band of rows into ESC * column data.  rows holds bandHeight
+// (8 or 24) rows of rowBytes bytes.  Bytes firstByte to firstByte+nBytes-1
+// of each row become 8 * nBytes columns of bandHeight / 8 bytes, top dot
+// in the most significant bit, stored one column after another in out.
+void ESC_POS_bandToColumns(const uint8_t *rows, int rowBytes, int bandHeight,
+        int firstByte, int nBytes, uint8_t *out);
+
+#endif // ESC_POS_IMAGE_H
@@ -0,0 +1,97 @@
+/*------------------------------------------------------------------------
+  Stored images for ESC_POS_Printer.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_ImageCache.h"
+
+// 32-bit FNV-1a hash of the image size and bits
+static uint32_t hashImage(int w, int h, const uint8_t *bitmap,
+        bool fromProgMem) {
+    uint32_t hash = 2166136261UL;
+    uint32_t len  = (uint32_t)((w + 7) / 8) * h;
+    uint8_t  size[4] = { (uint8_t)w, (uint8_t)(w >> 8),
+                         (uint8_t)h, (uint8_t)(h >> 8) };
+
+    for(uint8_t i = 0; i < sizeof(size); i++) {
+        hash = (hash ^ size[i]) * 16777619UL;
+    }
+    for(uint32_t i = 0; i < len; i++) {
+        uint8_t b = fromProgMem ? pgm_read_byte(bitmap + i) : bitmap[i];
+        hash = (hash ^ b) * 16777619UL;
+    }
+    return hash;
+}
+
+ESC_POS_ImageCache::ESC_POS_ImageCache(ESC_POS_Printer &printer) :
+    printer(printer), clock(0) {
+    clear();
+}
+
+// Only one GS * image fits in printers without download graphics
+uint8_t ESC_POS_ImageCache::slots() {
+    return printer.profile().graphicsMemory ? ESC_POS_IMAGE_CACHE_SLOTS : 1;
+}
+
+void ESC_POS_ImageCache::clear() {
+    for(uint8_t i = 0; i < slots(); i++) entries[i].valid = false;
+}
+
+void ESC_POS_ImageCache::forget(uint8_t key) {
+    for(uint8_t i = 0; i < slots(); i++) {
+        Entry &e = entries[i];
+        if(e.valid && (e.key == key)) {
+            if(e.resets == printer.resetCount()) printer.deleteStoredImage(key);
+            e.valid = false;
+        }
+    }
+}
+
+bool ESC_POS_ImageCache::printImage(
+        uint8_t key, int w, int h, const uint8_t *bitmap) {
+    return print(key, w, h, bitmap, false);
+}
+
+bool ESC_POS_ImageCache::printImage_P(
+        uint8_t key, int w, int h, const uint8_t *bitmap) {
+    return print(key, w, h, bitmap, true);
+}
+
+bool ESC_POS_ImageCache::print(uint8_t key, int w, int h,
+        const uint8_t *bitmap, bool fromProgMem) {
+    uint32_t hash   = hashImage(w, h, bitmap, fromProgMem);
+    uint16_t resets = printer.resetCount();
+    Entry   *e      = NULL;
+
+    // The key's own entry, else a free one, else the least recently used
+    for(uint8_t i = 0; i < slots(); i++) {
+        Entry &c = entries[i];
+        if(c.valid && (c.key == key)) {
+            e = &c;
+            break;
+        }
+        if(!e || (e->valid && (!c.valid || (uint16_t)(clock - c.used) >
+                (uint16_t)(clock - e->used)))) {
+            e = &c;
+        }
+    }
+
+    if(!e->valid || (e->key != key) || (e->hash != hash) ||
+            (e->resets != resets)) {
+        if(e->valid && (e->key != key) && (e->resets == resets)) {
+            printer.deleteStoredImage(e->key);
+        }
+        e->valid = false;
+        if(!printer.storeImage(key, w, h, bitmap, fromProgMem)) {
+            return fromProgMem ? printer.printImage_P(w, h, bitmap) :
+                                 printer.printImage(w, h, bitmap);
+        }
+        e->valid  = true;
+        e->key    = key;
+        e->hash   = hash;
+        e->resets = resets;
+    }
+    e->used = ++clock;
+    printer.printStoredImage(key, h);
+    return true;
+}
@@ -0,0 +1,62 @@
+/*------------------------------------------------------------------------
+  Stored images for ESC_POS_Printer.
+
+  A logo printed on every receipt need only cross the wire once.  The
+  cache uploads an image to the printer's download graphics memory the
+  first time it is printed under a key, then prints it with a short
+  command.  Each key remembers a hash of its image and the printer's
+  reset count, so a changed image or a reset printer gets the image sent
+  again without the caller noticing.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_IMAGE_CACHE_H
+#define ESC_POS_IMAGE_CACHE_H
+
+#include "ESC_POS_Printer.h"
+
+// Images kept in the printer at once; the least recently printed one
+// makes way for a new key.  Printers without download graphics hold one.
+#ifndef ESC_POS_IMAGE_CACHE_SLOTS
+#define ESC_POS_IMAGE_CACHE_SLOTS 4
+#endif
+
+class ESC_POS_ImageCache {
+
+    public:
+
+        ESC_POS_ImageCache(ESC_POS_Printer &printer);
+
+        // Print a row-major bitmap, as printImage(), stored under key.
+        // Images too big to store are printed the usual way.
+        bool
+            printImage(uint8_t key, int w, int h, const uint8_t *bitmap),
+            printImage_P(uint8_t key, int w, int h, const uint8_t *bitmap);
+        void
+            forget(uint8_t key), // Delete the image from the printer
+            clear();             // Forget all images
+
+    private:
+
+        struct Entry {
+            uint32_t hash;
+            uint16_t resets, // Printer reset count when stored
+                     used;   // Time of last print, for eviction
+            uint8_t  key;
+            bool     valid;
+        };
+
+        ESC_POS_Printer
+            &printer;
+        Entry
+            entries[ESC_POS_IMAGE_CACHE_SLOTS];
+        uint16_t
+            clock;
+        uint8_t
+            slots();
+        bool
+            print(uint8_t key, int w, int h, const uint8_t *bitmap,
+                    bool fromProgMem);
+};
+
+#endif // ESC_POS_IMAGE_CACHE_H
@@ -18,6 +18,7 @@ Reference: https://reference.epson-biz.com/modules/ref_escpos/index.php?content_
 ------------------------------------------------------------------------*/
 
 #include "ESC_POS_Printer.h"
+#include "ESC_POS_Commands.h"
 
 // ASCII codes used by some of the printer config commands:
 #define ASCII_TAB '\t' // Horizontal tab
@@ -27,45 +28,385 @@ Reference: https://reference.epson-biz.com/modules/ref_escpos/index.php?content_
 #define ASCII_EOT   4  // End of Transmission
 #define ASCII_DLE  16  // Data Link Escape
 #define ASCII_DC2  18  // Device control 2
+#define ASCII_DC4  20  // Device control 4
 #define ASCII_ESC  27  // Escape
 #define ASCII_FS   28  // Field separator
 #define ASCII_GS   29  // Group separator
 
+// tabCount after ESC @, which sets a tab stop every 8 columns
+#define TABS_DEFAULT 0xFF
+
+// Modes whose commands change where text wraps and how far lines feed;
+// command sequences changing them are read by trackCommands()
+#define LAYOUT_MODES ((1 << ESC_POS_Printer::MODE_PRINT) | \
+    (1 << ESC_POS_Printer::MODE_SIZE) | (1 << ESC_POS_Printer::MODE_LINE_HEIGHT))
+
+#if ESC_POS_STATS
+// Marks the output of a method as one kind (STAT_*) until it returns.
+// The innermost method decides, so a feed or a mode command inside a
+// barcode still counts as a feed or as style.
+class StatScope {
+    public:
+        StatScope(uint8_t &current, uint8_t kind) :
+            current(current), saved(current) { current = kind; }
+        ~StatScope() { current = saved; }
+    private:
+        uint8_t &current, saved;
+};
+#define STAT_KIND(k)     StatScope statScope(statKind, k)
+#define STAT_BYTES(n)    (total.bytes[statKind] += (n))
+#define STAT_COMMANDS(n) (total.commands[statKind] += (n))
+#define STAT_ROWS(p, f)  (total.printRows += (p), total.feedRows += (f))
+#else
+#define STAT_KIND(k)
+#define STAT_BYTES(n)
+#define STAT_COMMANDS(n)
+#define STAT_ROWS(p, f)
+#endif
+
+#if ESC_POS_PROFILE_FIXED
+constexpr ESC_POS_Profile ESC_POS_Printer::model;
+#endif
+
 // Constructor
-ESC_POS_Printer::ESC_POS_Printer(Stream *s) :
-    stream(s) {
+ESC_POS_Printer::ESC_POS_Printer(Stream *s, const ESC_POS_Profile &profile) :
+    stream(s),
+#if !ESC_POS_PROFILE_FIXED
+    model(profile),
+#endif
+    printMode(0), maxChunkHeight(256), outLen(0), encoder(NULL),
+    gather(NULL), encoding(false), autoCommit(true),
+    qrNative(model.qrCode),
+    spaceKnown(false), paperKnown(false), ring(NULL), priorityLen(0), ringSize(0), ringHead(0),
+    ringLen(0), statusFlags(0), asbEvents(0), asbIndex(0), pendingCount(0),
+    statusCallback(NULL), byteTime(0), dotPrintTime(0), dotFeedTime(0),
+    work(0), backlog(0), paceTime(0), printerBuffer(0), busyPin(-1),
+    busyLevel(HIGH), xonXoff(false), xoff(false), captureTo(NULL),
+    captureWork(0), capturePrint(true), shadowValid(0), resets(0) {
+#if ESC_POS_PROFILE_FIXED
+    (void)profile;
+#endif
+#if ESC_POS_STATS
+    memset(&total, 0, sizeof(total));
+    jobStart = total;
+    statKind = STAT_OTHER;
+#endif
+    }
+
+// All output passes through a small buffer so that a printed line or a
+// group of commands reaches the stream as one write instead of one write
+// per byte.  emit() appends to the buffer, send() passes it on to the
+// queue or to transmit(), which writes it to the stream.
+
+void ESC_POS_Printer::send(const uint8_t *buf, size_t len) {
+    if(captureTo) {
+        captureTo->write(buf, len);
+        if(!capturePrint) return;
+    }
+    if(!ring) {
+        transmit(buf, len);
+        return;
+    }
+    if(len > ringSize - ringLen) {
+        // No room: fall back to blocking writes of the oldest bytes, or
+        // of everything if buf is bigger than the whole queue
+        drain(len - (ringSize - ringLen));
+        if(len > ringSize) {
+            transmit(buf, len);
+            return;
+        }
+    }
+    while(len > 0) {
+        size_t tail = (ringHead + ringLen) % ringSize;
+        size_t n = min(len, ringSize - tail);
+        memcpy(ring + tail, buf, n);
+        ringLen += n;
+        buf     += n;
+        len     -= n;
+    }
+}
+
+// Two buffers in one write to a gathering stream, when they would go
+// straight to the stream anyway
+void ESC_POS_Printer::send(const uint8_t *a, size_t aLen,
+        const uint8_t *b, size_t bLen) {
+    if(!gather || ring || !unpaced()) {
+        if(aLen) send(a, aLen);
+        send(b, bLen);
+        return;
+    }
+    if(captureTo) {
+        captureTo->write(a, aLen);
+        captureTo->write(b, bLen);
+        if(!capturePrint) return;
+    }
+    gather->writeGather(a, aLen, b, bLen);
+}
+
+void ESC_POS_Printer::emit(uint8_t c) {
+    STAT_BYTES(1);
+    if(outLen >= sizeof(outBuf)) commit();
+    outBuf[outLen++] = c;
+}
+
+void ESC_POS_Printer::emit(const uint8_t *buf, size_t len) {
+    STAT_BYTES(len);
+    if(outLen + len > sizeof(outBuf)) {
+        // Too big to buffer, hand it to the stream as is, after what is
+        // buffered
+        if(len >= sizeof(outBuf)) {
+            send(outBuf, outLen, buf, len);
+            outLen = 0;
+            return;
+        }
+        commit();
+    }
+    memcpy(outBuf + outLen, buf, len);
+    outLen += len;
+}
+
+// Same as emit() for data stored in flash
+void ESC_POS_Printer::emit_P(const uint8_t *buf, size_t len) {
+    STAT_BYTES(len);
+    while(len > 0) {
+        if(outLen >= sizeof(outBuf)) commit();
+        size_t n = min(len, sizeof(outBuf) - outLen);
+        memcpy_P(outBuf + outLen, buf, n);
+        outLen += n;
+        buf    += n;
+        len    -= n;
+    }
+}
+
+// Send len bytes of commands from RAM and forget the modes they change.
+void ESC_POS_Printer::writeCommands(
+        const uint8_t *cmds, size_t len, uint16_t modes) {
+    STAT_KIND(modes ? (uint8_t)STAT_STYLE : statKind);
+    STAT_COMMANDS(1);
+    emit(cmds, len);
+    if(modes & LAYOUT_MODES) trackCommands(cmds, len, false);
+    shadowValid &= ~modes;
+}
+
+// Send len bytes of commands stored in flash, such as the sequences of
+// ESC_POS_Commands.h, and forget the modes (bits 1 << MODE_*) they change.
+// Where flash reads like RAM, sequences too big for the buffer go to the
+// stream in one write without being copied.
+void ESC_POS_Printer::writeCommands_P(
+        const uint8_t *cmds, size_t len, uint16_t modes) {
+    STAT_KIND(modes ? (uint8_t)STAT_STYLE : statKind);
+    STAT_COMMANDS(1);
+#if defined(__AVR__) || defined(ESP8266)
+    emit_P(cmds, len);
+#else
+    emit(cmds, len);
+#endif
+    if(modes & LAYOUT_MODES) trackCommands(cmds, len, true);
+    shadowValid &= ~modes;
+}
+
+// Send everything buffered so far to the printer.
+void ESC_POS_Printer::commit() {
+    if(outLen > 0) {
+        send(outBuf, outLen);
+        outLen = 0;
+    }
+}
+
+// With auto commit on (the default) the buffer is committed at the end of
+// every line, feed, bitmap and barcode.  Turn it off to collect a whole
+// receipt; the buffer is then only sent when full or on commit().
+void ESC_POS_Printer::setAutoCommit(bool on) {
+    autoCommit = on;
+    if(on) commit();
+}
+
+void ESC_POS_Printer::endLine() {
+    if(autoCommit) commit();
+}
+
+// === Capture and replay ===
+
+// Output can be recorded as it is sent and sent again later, e.g. for a
+// second copy of a receipt, without laying it out again (see
+// ESC_POS_Receipt.h).  Realtime commands are not recorded.
+
+// Command of each MODE_*, as given to writeMode()
+static const uint8_t modeCommands[][2] PROGMEM = {
+    { ASCII_ESC, '!' }, { ASCII_ESC, 'a' }, { ASCII_ESC, 'E' },
+    { ASCII_ESC, '-' }, { ASCII_ESC, 'G' }, { ASCII_GS,  'B' },
+    { ASCII_ESC, '{' }, { ASCII_ESC, '3' }, { ASCII_ESC, 'R' },
+    { ASCII_ESC, 't' }, { ASCII_ESC, ' ' }, { ASCII_GS,  '!' },
+    { ASCII_ESC, '=' }, { ASCII_GS,  'H' }, { ASCII_GS,  'w' }
+};
+
+// Copy all output from now on to to, and send it to the printer as well
+// if print is true.  The copy starts with the modes the printer is known
+// to be in, so it prints the same after other output has changed them,
+// and the encoder is reset so characters it downloads are in it too.
+void ESC_POS_Printer::startCapture(Print *to, bool print) {
+    commit();
+    for(uint8_t mode = 0; mode < MODE_COUNT; mode++) {
+        if((mode == MODE_ONLINE) || !(shadowValid & (1 << mode))) continue;
+        uint8_t cmd[3] = { pgm_read_byte(&modeCommands[mode][0]),
+                           pgm_read_byte(&modeCommands[mode][1]),
+                           shadow[mode] };
+        to->write(cmd, sizeof(cmd));
+    }
+    if(encoder) encoder->reset();
+    captureTo    = to;
+    capturePrint = print;
+    captureWork  = 0;
+}
+
+// Stop capturing.  Returns the printing time of the captured output in
+// microseconds (per setTimes()), to pass to replay() for pacing.  Output
+// captured without printing never reached the printer, so its modes,
+// stored images and the encoder's downloaded characters are forgotten,
+// as after invalidateState().
+unsigned long ESC_POS_Printer::endCapture() {
+    commit();
+    if(captureTo && !capturePrint) {
+        shadowValid = 0;
+        resets++;
+        if(encoder) encoder->reset();
     }
+    captureTo = NULL;
+    return captureWork;
+}
+
+// Send captured output again, in as few writes as the queue and pacing
+// allow.  The printer's modes are then whatever the capture left, so
+// they are all forgotten.
+void ESC_POS_Printer::replay(const uint8_t *data, size_t len,
+        unsigned long work) {
+    commit();
+    addTime(work);
+    STAT_BYTES(len);
+    send(data, len);
+    shadowValid = 0;
+    prevByte    = '\n';
+    column      = 0;
+}
+
+// Same for len captured bytes read back from a stream, e.g. a file.
+// Returns false if the stream timed out.
+bool ESC_POS_Printer::replay(Stream *from, size_t len, unsigned long work) {
+    commit();
+    addTime(work);
+    bool ok = (emitFrom(from, len, true) == len);
+    commit();
+    shadowValid = 0;
+    prevByte    = '\n';
+    column      = 0;
+    return ok;
+}
 
 // The next four helper methods are used when issuing configuration
 // commands, printing bitmaps or barcodes, etc.  Not when printing text.
 
 void ESC_POS_Printer::writeBytes(uint8_t a) {
-    stream->write(a);
+    STAT_COMMANDS(1);
+    emit(a);
 }
 
 void ESC_POS_Printer::writeBytes(uint8_t a, uint8_t b) {
+    STAT_COMMANDS(1);
     uint8_t cmd[2] = {a, b};
-    stream->write(cmd, sizeof(cmd));
+    emit(cmd, sizeof(cmd));
 }
 
 void ESC_POS_Printer::writeBytes(uint8_t a, uint8_t b, uint8_t c) {
+    STAT_COMMANDS(1);
     uint8_t cmd[3] = {a, b, c};
-    stream->write(cmd, sizeof(cmd));
+    emit(cmd, sizeof(cmd));
 }
 
 void ESC_POS_Printer::writeBytes(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    STAT_COMMANDS(1);
     uint8_t cmd[4] = {a, b, c, d};
-    stream->write(cmd, sizeof(cmd));
+    emit(cmd, sizeof(cmd));
+}
+
+// Mode commands go through here.  The command is skipped when the
+// printer is known to be in that mode already.  While the printer is
+// offline it ignores commands, so they are sent but not remembered.
+void ESC_POS_Printer::writeMode(
+        uint8_t mode, uint8_t a, uint8_t b, uint8_t val) {
+    uint16_t bit = 1 << mode;
+
+    if((shadowValid & bit) && (shadow[mode] == val)) return;
+    STAT_KIND(STAT_STYLE);
+    writeBytes(a, b, val);
+    shadow[mode] = val;
+    if((mode == MODE_ONLINE) || (shadowValid & (1 << MODE_ONLINE)) == 0 ||
+            shadow[MODE_ONLINE]) {
+        shadowValid |= bit;
+    } else {
+        shadowValid &= ~bit;
+    }
+}
+
+void ESC_POS_Printer::forgetMode(uint8_t mode) {
+    shadowValid &= ~(1 << mode);
+}
+
+// Forget everything known about the printer's modes, so the next mode
+// commands are all sent.  Call this when the printer may have lost its
+// settings behind our back, e.g. after power loss or an offline event.
+void ESC_POS_Printer::invalidateState() {
+    shadowValid  = 0;
+    pendingCount = 0; // Replies may never come
+    resets++;
+}
+
+// Counts reset() and invalidateState() calls, after which images stored
+// with storeImage() may be gone.
+uint16_t ESC_POS_Printer::resetCount() {
+    return resets;
+}
+
+// The profile given to the constructor
+const ESC_POS_Profile &ESC_POS_Printer::profile() {
+    return model;
 }
 
+#if ESC_POS_STATS
+// Everything counted since the printer object was made
+const ESC_POS_Stats &ESC_POS_Printer::stats() {
+    return total;
+}
+
+// What was counted since the last startJob()
+ESC_POS_Stats ESC_POS_Printer::jobStats() {
+    ESC_POS_Stats job;
+    for(uint8_t i = 0; i < STAT_KINDS; i++) {
+        job.bytes[i]    = total.bytes[i]    - jobStart.bytes[i];
+        job.commands[i] = total.commands[i] - jobStart.commands[i];
+    }
+    job.printRows = total.printRows - jobStart.printRows;
+    job.feedRows  = total.feedRows  - jobStart.feedRows;
+    return job;
+}
+
+void ESC_POS_Printer::startJob() {
+    jobStart = total;
+}
+#endif
+
 // The underlying method for all high-level printing (e.g. println()).
 // The inherited Print class handles the rest!
 size_t ESC_POS_Printer::write(uint8_t c) {
+    STAT_KIND(STAT_TEXT);
+
+    if(encoder && !encoding) return write(&c, 1);
 
     if(c != 0x13) { // Strip carriage returns
-        stream->write(c);
+        emit(c);
         if((c == '\n') || (column == maxColumn)) { // If newline or wrap
+            addWork(charHeight, lineSpacing);
             column = 0;
+            if(c == '\n') endLine();
             c      = '\n'; // Treat wrap as newline on next pass
         } else {
             column++;
@@ -76,6 +417,75 @@ size_t ESC_POS_Printer::write(uint8_t c) {
     return 1;
 }
 
+// Print::print() and println() of strings arrive here in one piece.
+// The text is scanned for line ends and passed on in whole spans rather
+// than byte by byte; column and prevByte end up exactly as if every byte
+// had gone through write(uint8_t).
+size_t ESC_POS_Printer::write(const uint8_t *buffer, size_t size) {
+    STAT_KIND(STAT_TEXT);
+    const uint8_t *p   = buffer;
+    const uint8_t *end = buffer + size;
+    bool newline = false;
+
+    if(encoder && !encoding) {
+        encoding = true;
+        encoder->write(*this, buffer, size);
+        encoding = false;
+        return size;
+    }
+
+    while(p < end) {
+        if(column > maxColumn) {
+            // Page got narrower mid-line; step bytes until back in range
+            uint8_t c = *p++;
+            if(c == 0x13) continue;
+            emit(c);
+            if(c == '\n') {
+                addWork(charHeight, lineSpacing);
+                column  = 0;
+                newline = true;
+            } else {
+                column++;
+            }
+            prevByte = c;
+            continue;
+        }
+
+        // Longest span without a newline or stripped byte
+        const uint8_t *stop = (const uint8_t *)memchr(p, '\n', end - p);
+        if(!stop) stop = end;
+        const uint8_t *dc3 = (const uint8_t *)memchr(p, 0x13, stop - p);
+        if(dc3) stop = dc3;
+
+        size_t n = stop - p;
+        if(n > 0) {
+            emit(p, n);
+            // Each byte moves one column right, wrapping past maxColumn
+            // to 0, and a wrap counts as a newline.
+            unsigned int wraps = (column + n) / (maxColumn + 1);
+            if(wraps) addWork(wraps * charHeight, wraps * lineSpacing);
+            column   = (column + n) % (maxColumn + 1);
+            prevByte = column ? stop[-1] : '\n';
+            p        = stop;
+        }
+
+        if(p < end) {
+            if(*p == '\n') {
+                emit('\n');
+                addWork(charHeight, lineSpacing);
+                column   = 0;
+                prevByte = '\n';
+                newline  = true;
+            }
+            p++; // Newline sent or carriage return stripped
+        }
+    }
+
+    if(newline) endLine();
+
+    return size;
+}
+
 void ESC_POS_Printer::begin() {
 
     // The printer can't start receiving data immediately upon power up --
@@ -89,12 +499,35 @@ void ESC_POS_Printer::begin() {
 // Reset printer to default state.
 void ESC_POS_Printer::reset() {
     writeBytes(ASCII_ESC, '@'); // Init command
+    if(model.statusBack && asbEvents)
+        writeBytes(ASCII_GS, 'a', asbEvents); // ESC @ turns ASB off
+    resetLayout();
+
+    // ESC @ restores these modes.  Line spacing, character set, code
+    // page and online state come back as set by the printer's switches.
+    memset(shadow, 0, sizeof(shadow));
+    shadowValid = (1 << MODE_PRINT)     | (1 << MODE_JUSTIFY)     |
+                  (1 << MODE_BOLD)      | (1 << MODE_UNDERLINE)   |
+                  (1 << MODE_STRIKE)    | (1 << MODE_INVERSE)     |
+                  (1 << MODE_UPSIDE_DOWN) | (1 << MODE_CHAR_SPACING) |
+                  (1 << MODE_SIZE);
+}
+
+// What ESC @ does to the layout kept here, and to stored data
+void ESC_POS_Printer::resetLayout() {
+    printMode     =    0;
     prevByte      = '\n';       // Treat as if prior line is blank
     column        =    0;
-    maxColumn     =   32;
+    maxColumn     = model.columns;
     charHeight    =   24;
     lineSpacing   =    6;
     barcodeHeight =   50;
+    barcodeText   =    2;
+    barcodeWidth  =    3;
+    tabCount      = TABS_DEFAULT;
+    pendingCount  =    0;
+    resets++;
+    if(encoder) encoder->reset();
 }
 
 // Reset text formatting parameters.
@@ -107,6 +540,8 @@ void ESC_POS_Printer::setDefault(){
     boldOff();
     underlineOff();
     setBarcodeHeight(50);
+    setBarcodeText();
+    setBarcodeWidth();
     setSize('s');
     setCharset();
     setCodePage();
@@ -118,8 +553,10 @@ void ESC_POS_Printer::test(){
 }
 
 void ESC_POS_Printer::testPage() {
-    char commandTest[] = {ASCII_GS, '(', 'A', 2, 0, 0, 3};
-    stream->write(commandTest, sizeof(commandTest));
+    uint8_t commandTest[] = {ASCII_GS, '(', 'A', 2, 0, 0, 3};
+    STAT_COMMANDS(1);
+    emit(commandTest, sizeof(commandTest));
+    endLine();
 }
 
 void ESC_POS_Printer::setBarcodeHeight(uint8_t val) { // Default is 50
@@ -129,14 +566,44 @@ void ESC_POS_Printer::setBarcodeHeight(uint8_t val) { // Default is 50
     //writeBytes(ASCII_GS, 'h', val);
 }
 
-void ESC_POS_Printer::printBarcode(const char *text, uint8_t type) {
-    feed(1); // Recent firmware can't print barcode w/o feed first???
-    writeBytes(ASCII_GS, 'H', 2);    // Print label below barcode
-    writeBytes(ASCII_GS, 'w', 3);    // Barcode width 3 (0.375/1.0mm thin/thick)
-    writeBytes(ASCII_GS, 'k', type); // Barcode type (listed in .h file)
-    // Write text including the terminating '\0'
-    stream->write(text, strlen(text)+1);
+// Text printed with barcodes: 0 none, 1 above, 2 below, 3 both
+void ESC_POS_Printer::setBarcodeText(uint8_t position) {
+    barcodeText = position & 3;
+}
+
+// Width of the narrowest bar in dots, 2 to 6
+void ESC_POS_Printer::setBarcodeWidth(uint8_t val) {
+    barcodeWidth = constrain(val, 2, 6);
+}
+
+// Print a barcode with GS k function B.  CODE128 text is encoded with
+// the code sets that make the shortest symbol (see ESC_POS_Barcode.h),
+// unless it starts with '{' and so names its own.  Returns false if the
+// text cannot be encoded or is over 255 bytes.
+bool ESC_POS_Printer::printBarcode(const char *text, uint8_t type) {
+    STAT_KIND(STAT_BARCODE);
+    const uint8_t *data = (const uint8_t *)text;
+    size_t len = strlen(text);
+    uint8_t code128[255];
+
+    if((type == CODE128) && (text[0] != '{')) {
+        len  = encodeCode128(data, len, code128, sizeof(code128));
+        data = code128;
+    }
+    if(!len || (len > 255)) return false;
+
+    // GS k is ignored while a line is part printed
+    if(prevByte != '\n') feed(1);
+    writeMode(MODE_BARCODE_TEXT, ASCII_GS, 'H', barcodeText);
+    writeMode(MODE_BARCODE_WIDTH, ASCII_GS, 'w', barcodeWidth);
+    writeBytes(ASCII_GS, 'k', type, len);
+    emit(data, len);
+    uint8_t lines = (barcodeText == 3) ? 2 : (barcodeText ? 1 : 0);
+    addWork(barcodeHeight + lines * charHeight, 0); // Bars and text
     prevByte = '\n';
+    column   = 0;
+    endLine();
+    return true;
 }
 
 // === Character commands ===
@@ -153,18 +620,83 @@ void ESC_POS_Printer::setPrintMode(uint8_t mask) {
     printMode |= mask;
     writePrintMode();
     charHeight = (printMode & DOUBLE_HEIGHT_MASK) ? 48 : 24;
-    maxColumn  = (printMode & DOUBLE_WIDTH_MASK ) ? 16 : 32;
+    maxColumn  = model.columns / ((printMode & DOUBLE_WIDTH_MASK) ? 2 : 1);
 }
 
 void ESC_POS_Printer::unsetPrintMode(uint8_t mask) {
     printMode &= ~mask;
     writePrintMode();
     charHeight = (printMode & DOUBLE_HEIGHT_MASK) ? 48 : 24;
-    maxColumn  = (printMode & DOUBLE_WIDTH_MASK ) ? 16 : 32;
+    maxColumn  = model.columns / ((printMode & DOUBLE_WIDTH_MASK) ? 2 : 1);
 }
 
 void ESC_POS_Printer::writePrintMode() {
-    writeBytes(ASCII_ESC, '!', printMode);
+    writeMode(MODE_PRINT, ASCII_ESC, '!', printMode);
+}
+
+static uint8_t commandByte(const uint8_t *cmds, size_t i, bool fromProgMem) {
+    return fromProgMem ? pgm_read_byte(cmds + i) : cmds[i];
+}
+
+// Follow the print mode, size and line spacing commands in a sequence
+// sent with writeCommands(), so text wraps and feeds as they say.
+// Commands are ESC or GS, a letter and parameters; ones of other forms
+// or variable length end the scan, leaving the rest unread.
+void ESC_POS_Printer::trackCommands(const uint8_t *cmds, size_t len,
+        bool fromProgMem) {
+    size_t i = 0;
+
+    while(i + 1 < len) {
+        uint8_t c = commandByte(cmds, i, fromProgMem), n = 0;
+        size_t size = 3;
+        if((c != ASCII_ESC) && (c != ASCII_GS)) {
+            i++; // Text or a single byte command
+            continue;
+        }
+        uint8_t cmd = commandByte(cmds, i + 1, fromProgMem);
+        if(i + 2 < len) n = commandByte(cmds, i + 2, fromProgMem);
+        if(c == ASCII_ESC) {
+            switch(cmd) {
+                case '@': // ESC @
+                    resetLayout();
+                    prevByte = '\n';
+                    column   = 0;
+                    size     = 2;
+                    break;
+                case '2': // ESC 2
+                    lineSpacing = 6;
+                    size        = 2;
+                    break;
+                case '3': // ESC 3 n
+                    lineSpacing = (n > 24) ? n - 24 : 0;
+                    break;
+                case '!': // ESC ! n
+                    printMode  = n;
+                    charHeight = (printMode & DOUBLE_HEIGHT_MASK) ? 48 : 24;
+                    maxColumn  = model.columns / ((printMode & DOUBLE_WIDTH_MASK) ? 2 : 1);
+                    break;
+                case '$': case '8': size = 4; break;
+                case 'p': size = 5; break;
+                case 'D': case '*': return;
+            }
+        } else {
+            switch(cmd) {
+                case '!': // GS ! n
+                    charHeight = 24 * ((n & 0x07) + 1);
+                    maxColumn  = model.columns / (((n >> 4) & 0x07) + 1);
+                    prevByte   = '\n';
+                    break;
+                case 'V': size = (n >= 65) ? 4 : 3; break;
+                case '(': // GS ( fn pL pH, then pL + 256 pH bytes
+                    if(i + 4 >= len) return;
+                    size = 5 + commandByte(cmds, i + 3, fromProgMem) +
+                        ((size_t)commandByte(cmds, i + 4, fromProgMem) << 8);
+                    break;
+                case 'v': case 'k': case '*': return;
+            }
+        }
+        i += size;
+    }
 }
 
 void ESC_POS_Printer::normal() {
@@ -174,19 +706,19 @@ void ESC_POS_Printer::normal() {
 }
 
 void ESC_POS_Printer::inverseOn(){
-    writeBytes(ASCII_GS, 'B', 1);
+    writeMode(MODE_INVERSE, ASCII_GS, 'B', 1);
 }
 
 void ESC_POS_Printer::inverseOff(){
-    writeBytes(ASCII_GS, 'B', 0);
+    writeMode(MODE_INVERSE, ASCII_GS, 'B', 0);
 }
 
 void ESC_POS_Printer::upsideDownOn(){
-    writeBytes(ASCII_ESC, '{', 1);
+    writeMode(MODE_UPSIDE_DOWN, ASCII_ESC, '{', 1);
 }
 
 void ESC_POS_Printer::upsideDownOff(){
-    writeBytes(ASCII_ESC, '{', 0);
+    writeMode(MODE_UPSIDE_DOWN, ASCII_ESC, '{', 0);
 }
 
 void ESC_POS_Printer::doubleHeightOn(){
@@ -206,19 +738,19 @@ void ESC_POS_Printer::doubleWidthOff(){
 }
 
 void ESC_POS_Printer::strikeOn(){
-    writeBytes(ASCII_ESC, 'G', 1);
+    writeMode(MODE_STRIKE, ASCII_ESC, 'G', 1);
 }
 
 void ESC_POS_Printer::strikeOff(){
-    writeBytes(ASCII_ESC, 'G', 0);
+    writeMode(MODE_STRIKE, ASCII_ESC, 'G', 0);
 }
 
 void ESC_POS_Printer::boldOn(){
-    writeBytes(ASCII_ESC, 'E', 1);
+    writeMode(MODE_BOLD, ASCII_ESC, 'E', 1);
 }
 
 void ESC_POS_Printer::boldOff(){
-    writeBytes(ASCII_ESC, 'E', 0);
+    writeMode(MODE_BOLD, ASCII_ESC, 'E', 0);
 }
 
 void ESC_POS_Printer::justify(char value){
@@ -230,25 +762,54 @@ void ESC_POS_Printer::justify(char value){
         case 'R': pos = 2; break;
     }
 
-    writeBytes(ASCII_ESC, 'a', pos);
+    writeMode(MODE_JUSTIFY, ASCII_ESC, 'a', pos);
+}
+
+// 'L', 'C' or 'R' as last given to justify(), or 0 if not known (after
+// invalidateState() or a command sequence that justifies)
+char ESC_POS_Printer::justification() {
+    if(!(shadowValid & (1 << MODE_JUSTIFY))) return 0;
+    return "LCR"[min(shadow[MODE_JUSTIFY], (uint8_t)2)];
 }
 
 // Feeds by the specified number of lines
 void ESC_POS_Printer::feed(uint8_t x) {
+    STAT_KIND(STAT_FEED);
     writeBytes(ASCII_ESC, 'd', x);
+    addWork(0, x * (charHeight + lineSpacing));
     prevByte = '\n';
     column   =    0;
+    endLine();
 }
 
 // Feeds by the specified number of individual pixel rows
 void ESC_POS_Printer::feedRows(uint8_t rows) {
+    STAT_KIND(STAT_FEED);
     writeBytes(ASCII_ESC, 'J', rows);
+    addWork(0, rows);
     prevByte = '\n';
     column   =    0;
+    endLine();
+}
+
+// Feed the paper to the cutter and cut it, leaving a strip uncut if
+// partial is true.  Printers without a cutter feed to the tear bar.
+void ESC_POS_Printer::cut(bool partial) {
+    STAT_KIND(STAT_FEED);
+    if(model.cutter) {
+        writeBytes(ASCII_GS, 'V', partial ? 66 : 65, 0); // Feed and cut
+        prevByte = '\n';
+        column   = 0;
+        endLine();
+    } else {
+        feed(3);
+    }
 }
 
 void ESC_POS_Printer::flush() {
+    STAT_KIND(STAT_FEED);
     writeBytes(ASCII_FF);
+    endLine();
 }
 
 void ESC_POS_Printer::setSize(char value){
@@ -258,28 +819,28 @@ void ESC_POS_Printer::setSize(char value){
         default:  // Small: standard width and height
             size       = 0x00;
             charHeight = 24;
-            maxColumn  = 32;
+            maxColumn  = model.columns;
             break;
         case 'M': // Medium: double height
             size       = 0x01;
             charHeight = 48;
-            maxColumn  = 32;
+            maxColumn  = model.columns;
             break;
         case 'L': // Large: double width and height
             size       = 0x11;
             charHeight = 48;
-            maxColumn  = 64;
+            maxColumn  = model.columns / 2;
             break;
     }
 
-    writeBytes(ASCII_GS, '!', size);
+    writeMode(MODE_SIZE, ASCII_GS, '!', size);
     prevByte = '\n'; // Setting the size adds a linefeed
 }
 
 void ESC_POS_Printer::setSize(uint8_t height, uint8_t width) {
     uint8_t size = ((width & 0x7) << 3) | (height & 0x7);
 
-    writeBytes(ASCII_GS, '!', size);
+    writeMode(MODE_SIZE, ASCII_GS, '!', size);
     prevByte = '\n'; // Setting the size adds a linefeed
 }
 
@@ -289,13 +850,17 @@ void ESC_POS_Printer::setSize(uint8_t height, uint8_t width) {
 // 2 - thick underline
 void ESC_POS_Printer::underlineOn(uint8_t weight) {
     if(weight > 2) weight = 2;
-    writeBytes(ASCII_ESC, '-', weight);
+    writeMode(MODE_UNDERLINE, ASCII_ESC, '-', weight);
 }
 
 void ESC_POS_Printer::underlineOff() {
-    writeBytes(ASCII_ESC, '-', 0);
+    writeMode(MODE_UNDERLINE, ASCII_ESC, '-', 0);
 }
 
+// Line spacing 16 dots and unidirectional print mode around ESC * bands
+typedef ESC_POS_Cat<ESC_POS_LineHeight<16>, ESC_POS_Unidirectional<1> >::type BitmapStart;
+typedef ESC_POS_Cat<ESC_POS_DefaultLineHeight, ESC_POS_Unidirectional<0> >::type BitmapEnd;
+
 // ASCII  ESC *   m nL nH d1...dk
 // Hex    1B  2A  m nL nH d1...dk
 // Dec    27  42  m nL nH d1...dk
@@ -305,6 +870,7 @@ void ESC_POS_Printer::underlineOff() {
 // m = 33 double density vert, double horiz
 void ESC_POS_Printer::printBitmap(
         int w, int h, const uint8_t *bitmap, int density) {
+    STAT_KIND(STAT_IMAGE);
     uint8_t band_height;
     uint8_t bitmap_command[] = { 0x1b, '*', 0, 0, 0 };
     size_t w_bytes = w;
@@ -326,25 +892,26 @@ void ESC_POS_Printer::printBitmap(
     bitmap_command[3] = w & 0xFF;       // nL = width LS byte
     bitmap_command[4] = (w >> 8) & 0xFF;// nH = width MS byte
 
-    // Line spacing = 16 dots
-    stream->write("\x1b\x33\x10\x1bU\x01");   // Unidirectional print mode on
+    command<BitmapStart>();
     for (int row = 0; row < h; row += band_height) {
-        stream->write(bitmap_command, sizeof(bitmap_command));
-        stream->write(bitmap, w_bytes);
-        stream->write('\n');
+        STAT_COMMANDS(1);
+        emit(bitmap_command, sizeof(bitmap_command));
+        emit(bitmap, w_bytes);
+        emit('\n');
         bitmap += w_bytes;
     }
-    stream->write("\x1b\x32\x1bU");     // Default line spacing
-    stream->write((uint8_t)0);          // Unidirectional print mode off
+    command<BitmapEnd>();
+    addWork(h, 0);
     prevByte = '\n';
+    endLine();
 }
 
 void ESC_POS_Printer::printBitmap_P(
         int w, int h, const uint8_t *bitmap, int density) {
+    STAT_KIND(STAT_IMAGE);
     uint8_t band_height;
     uint8_t bitmap_command[] = { 0x1b, '*', 0, 0, 0 };
     size_t w_bytes = w;
-    uint8_t buf[64];
     PGM_P p = reinterpret_cast<PGM_P>(bitmap);
 
     switch (density) {
@@ -364,37 +931,30 @@ void ESC_POS_Printer::printBitmap_P(
     bitmap_command[3] = w & 0xFF;       // nL = width LS byte
     bitmap_command[4] = (w >> 8) & 0xFF;// nH = width MS byte
 
-    // Line spacing = 16 dots
-    stream->write("\x1b\x33\x10\x1bU\x01");   // Unidirectional print mode on
+    command<BitmapStart>();
     for (int row = 0; row < h; row += band_height) {
-        memcpy(buf, bitmap_command, sizeof(bitmap_command));
-        size_t len = sizeof(bitmap_command);
-        size_t outlen;
-        for (size_t col = 0; col < w_bytes; col += outlen) {
-            outlen = min(sizeof(buf)-len, w_bytes - col);
-            memcpy_P(buf+len, p, outlen);
-            len += outlen;
-            p += outlen;
-            stream->write(buf, len);
-            len = 0;
-        }
-        stream->write('\n');
+        STAT_COMMANDS(1);
+        emit(bitmap_command, sizeof(bitmap_command));
+        emit_P(reinterpret_cast<const uint8_t *>(p), w_bytes);
+        p += w_bytes;
+        emit('\n');
     }
-    // The count correctly includes the trailing '\0'!
-    stream->write("\x1b\x32\x1bU", 5);    // Default line spacing,
-    // Unidirectional print mode off
+    command<BitmapEnd>();
+    addWork(h, 0);
     prevByte = '\n';
+    endLine();
 }
 
 void ESC_POS_Printer::printBitmap(
         int w, int h, const uint8_t *bitmap, bool fromProgMem) {
+    STAT_KIND(STAT_IMAGE);
     int rowBytes, rowBytesClipped, rowStart, chunkHeight, chunkHeightLimit,
         x, y, i;
 
     rowBytes        = (w + 7) / 8; // Round up to next byte boundary
-    rowBytesClipped = (rowBytes >= 48) ? 48 : rowBytes; // 384 pixels max width
+    rowBytesClipped = min(rowBytes, model.dots / 8); // Paper width
 
-    chunkHeightLimit = 255; // Buffer doesn't matter, handshake!
+    chunkHeightLimit = min((int)maxChunkHeight, 255); // DC2 * limit
 
     for(i=rowStart=0; rowStart < h; rowStart += chunkHeightLimit) {
         // Issue up to chunkHeightLimit rows at a time:
@@ -405,66 +965,925 @@ void ESC_POS_Printer::printBitmap(
 
         for(y=0; y < chunkHeight; y++) {
             for(x=0; x < rowBytesClipped; x++, i++) {
-                stream->write(fromProgMem ? pgm_read_byte(bitmap + i) : *(bitmap+i));
+                emit(fromProgMem ? pgm_read_byte(bitmap + i) : *(bitmap+i));
             }
             i += rowBytes - rowBytesClipped;
         }
     }
+    addWork(h, 0);
     prevByte = '\n';
+    endLine();
 }
 
-void ESC_POS_Printer::printBitmap(int w, int h, Stream *fromStream) {
-    int rowBytes, rowBytesClipped, rowStart, chunkHeight, chunkHeightLimit,
-        x, y, i, c;
+// Move len bytes from a stream straight into the output buffer, or read
+// and drop them if keep is false.  Whatever the stream already holds is
+// taken in one readBytes(), so the stream's own receive buffer fills with
+// the next chunk while outBuf is being sent to the printer.  Only an
+// empty stream waits, for at most the stream's timeout (setTimeout()).
+// Returns the number of bytes moved, less than len if the stream timed out.
+size_t ESC_POS_Printer::emitFrom(Stream *s, size_t len, bool keep) {
+    size_t done = 0;
+    while(done < len) {
+        if(outLen >= sizeof(outBuf)) commit();
+        size_t n = s->available();
+        if(n < 1) n = 1;
+        n = min(n, min(len - done, sizeof(outBuf) - outLen));
+        n = s->readBytes(outBuf + outLen, n);
+        if(n == 0) break;
+        if(keep) {
+            outLen += n;
+            STAT_BYTES(n);
+        }
+        done += n;
+    }
+    return done;
+}
+
+// Returns false if the stream timed out.  The chunk being sent is then
+// completed with white, so the printer is not left waiting for data.
+bool ESC_POS_Printer::printBitmap(int w, int h, Stream *fromStream) {
+    STAT_KIND(STAT_IMAGE);
+    int rowBytes, rowBytesClipped, rowStart, chunkHeight, chunkHeightLimit, y;
+    bool ok = true;
 
     rowBytes        = (w + 7) / 8; // Round up to next byte boundary
-    rowBytesClipped = (rowBytes >= 48) ? 48 : rowBytes; // 384 pixels max width
+    rowBytesClipped = min(rowBytes, model.dots / 8); // Paper width
 
-    // Est. max rows to write at once, assuming 256 byte printer buffer.
-    chunkHeightLimit = 255; // Buffer doesn't matter, handshake!
+    chunkHeightLimit = min((int)maxChunkHeight, 255); // DC2 * limit
 
-    for(rowStart=0; rowStart < h; rowStart += chunkHeightLimit) {
+    for(rowStart=0; ok && (rowStart < h); rowStart += chunkHeightLimit) {
         // Issue up to chunkHeightLimit rows at a time:
         chunkHeight = h - rowStart;
         if(chunkHeight > chunkHeightLimit) chunkHeight = chunkHeightLimit;
 
         writeBytes(ASCII_DC2, '*', chunkHeight, rowBytesClipped);
 
-        for(y=0; y < chunkHeight; y++) {
-            for(x=0; x < rowBytesClipped; x++) {
-                while((c = fromStream->read()) < 0);
-                stream->write((uint8_t)c);
+        size_t want = (size_t)chunkHeight * rowBytesClipped, sent = 0;
+        if(rowBytes == rowBytesClipped) {
+            // Rows are sent whole, take the chunk in one go
+            sent = emitFrom(fromStream, want, true);
+        } else {
+            size_t skip = rowBytes - rowBytesClipped;
+            for(y=0; y < chunkHeight; y++) {
+                size_t n = emitFrom(fromStream, rowBytesClipped, true);
+                sent += n;
+                if((n < (size_t)rowBytesClipped) ||
+                   (emitFrom(fromStream, skip, false) < skip)) {
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        if(sent < want) ok = false;
+        for(; sent < want; sent++) emit(0);
+    }
+    addWork(h, 0);
+    prevByte = '\n';
+    endLine();
+    return ok;
+}
+
+// Print a bitmap that starts with its width and height, each 16 bits
+// LSB first.  Returns false if the stream timed out.
+bool ESC_POS_Printer::printBitmap(Stream *fromStream) {
+    uint8_t header[4];
+
+    if(fromStream->readBytes(header, sizeof(header)) != sizeof(header))
+        return false;
+    return printBitmap(header[0] | (header[1] << 8),
+                       header[2] | (header[3] << 8), fromStream);
+}
+
+// Print a row-major image (see ESC_POS_Image.h) in the given graphics
+// mode.  Returns false if the rows ran out early; the band or chunk being
+// sent is then completed with white.
+bool ESC_POS_Printer::printImage(
+        int w, int h, ESC_POS_RowSource &rows, int density) {
+    STAT_KIND(STAT_IMAGE);
+    addWork(h, 0);
+    if(density == BITMAP_RASTER) {
+        if(model.rasterGraphics) return printRaster(w, h, rows);
+        density = BITMAP_24DOT; // Same resolution in ESC * bands
+    }
+    return printBands(w, h, rows, density);
+}
+
+// Find the first and last bytes holding black dots in n rows of an
+// image.  Returns false if the rows are all white.
+static bool findInk(const uint8_t *rows, int n, int rowBytes,
+        int *first, int *last) {
+    int f = rowBytes, l = -1;
+
+    for(int r = 0; r < n; r++, rows += rowBytes) {
+        int b = 0;
+        while((b < f) && !rows[b]) b++;
+        if(b < f) f = b;
+        b = rowBytes - 1;
+        while((b > l) && !rows[b]) b--;
+        if(b > l) l = b;
+    }
+    *first = f;
+    *last  = l;
+    return l >= 0;
+}
+
+static bool isWhite(const uint8_t *row, int rowBytes) {
+    while(rowBytes--) {
+        if(*row++) return false;
+    }
+    return true;
+}
+
+// Images only skip white margins when left justified; a narrower image
+// would move when centred or right justified.
+bool ESC_POS_Printer::leftJustified() {
+    return (shadowValid & (1 << MODE_JUSTIFY)) && (shadow[MODE_JUSTIFY] == 0);
+}
+
+// Advance the paper past white rows of an image instead of sending them
+void ESC_POS_Printer::skipDots(int dots) {
+    while(dots > 0) {
+        int n = min(dots, 255);
+        writeBytes(ASCII_ESC, 'J', n);
+        dots -= n;
+    }
+}
+
+// ESC * bit image bands.  The rows of each band are turned into column
+// data on the fly, a chunk at a time, so only one band of rows is ever
+// held in memory.  All white bands become a paper feed and, when left
+// justified, white columns either side are left out, moving the band
+// into place with ESC $.
+bool ESC_POS_Printer::printBands(
+        int w, int h, ESC_POS_RowSource &rows, int density) {
+    const int maxBytes = ESC_POS_IMAGE_MAX_WIDTH / 8;
+    const int chunkBytes = 16; // Row bytes turned into columns per pass
+    uint8_t band[24 * maxBytes];
+    uint8_t columns[chunkBytes * 8 * 3];
+    uint8_t bitmap_command[] = { ASCII_ESC, '*', 0, 0, 0 };
+    int bandHeight, advance, unitsPerDot, rowBytes, dots, feed = 0;
+    bool ok = true, trim = leftJustified();
+
+    if(density == BITMAP_24DOT) {
+        bitmap_command[2] = 33; // m = 24-dot double density
+        bandHeight  = 24;
+        advance     = 24;
+        unitsPerDot =  1;
+    } else {
+        bitmap_command[2] = 0;  // m = 8-dot single density
+        bandHeight  =  8;
+        advance     = 16;       // As printBitmap(), see qrcode/qrband.py
+        unitsPerDot =  2;       // Half horizontal density
+    }
+    rowBytes = (w + 7) / 8;
+    rowBytes = min(rowBytes, min(maxBytes, model.dots / 8)); // Paper width
+    dots = min(w, rowBytes * 8);
+
+    // Line spacing = band height, unidirectional print mode on
+    bool hadSpacing = shadowValid & (1 << MODE_LINE_HEIGHT);
+    uint8_t oldSpacing = shadow[MODE_LINE_HEIGHT];
+    writeMode(MODE_LINE_HEIGHT, ASCII_ESC, '3', advance);
+    writeBytes(ASCII_ESC, 'U', 1);
+
+    for(int row = 0; ok && (row < h); row += bandHeight) {
+        int n = min(bandHeight, h - row);
+        int r, first, last, from, to;
+        for(r = 0; r < n; r++) {
+            if(!rows.readRow(band + r * rowBytes, rowBytes)) {
+                ok = false;
+                break;
+            }
+        }
+        memset(band + r * rowBytes, 0, (bandHeight - r) * rowBytes);
+
+        if(!findInk(band, bandHeight, rowBytes, &first, &last)) {
+            feed += advance;
+            continue;
+        }
+        skipDots(feed);
+        feed = 0;
+
+        // Columns from..to-1 are sent
+        from = 0;
+        to   = dots;
+        if(trim) {
+            uint8_t bits = 0;
+            for(r = 0; r < bandHeight; r++) bits |= band[r * rowBytes + last];
+            int lastDot = last * 8 + 7;
+            while(!(bits & 1)) {
+                bits >>= 1;
+                lastDot--;
+            }
+            from = first * 8;
+            to   = min(dots, lastDot + 1);
+            if(from > 0) {
+                int pos = from * unitsPerDot;
+                writeBytes(ASCII_ESC, '$', pos & 0xFF, pos >> 8);
+            }
+        }
+        bitmap_command[3] = (to - from) & 0xFF;        // nL = width LS byte
+        bitmap_command[4] = ((to - from) >> 8) & 0xFF; // nH = width MS byte
+        STAT_COMMANDS(1);
+        emit(bitmap_command, sizeof(bitmap_command));
+
+        int colBytes = bandHeight / 8;
+        for(int b = from / 8; b * 8 < to; b += chunkBytes) {
+            int nb = min(chunkBytes, rowBytes - b);
+            int ncols = min(nb * 8, to - b * 8);
+            ESC_POS_bandToColumns(band, rowBytes, bandHeight, b, nb, columns);
+            emit(columns, ncols * colBytes);
+        }
+        emit('\n');
+    }
+    skipDots(feed);
+
+    // Restore line spacing, unidirectional print mode off
+    if(hadSpacing) {
+        writeMode(MODE_LINE_HEIGHT, ASCII_ESC, '3', oldSpacing);
+    } else {
+        writeBytes(ASCII_ESC, '2');
+        forgetMode(MODE_LINE_HEIGHT);
+    }
+    writeBytes(ASCII_ESC, 'U', 0);
+    prevByte = '\n';
+    column   = 0;
+    endLine();
+    return ok;
+}
+
+// Send n rows of a raster image held in memory.  Runs of white rows
+// become paper feed (counted up in feed and sent before the next rows
+// with ink); a run short enough that sending it costs less than a new
+// command header stays in the image.  When trimming, white bytes either
+// side of each command's rows are left out and the left margin (GS L)
+// moves the image into place.
+void ESC_POS_Printer::rasterRows(const uint8_t *rows, int n, int rowBytes,
+        bool trim, int &feed, int &margin) {
+    const int overhead = 16; // Bytes of a raster header plus GS L and ESC J
+    int r = 0;
+
+    while(r < n) {
+        while((r < n) && isWhite(rows + r * rowBytes, rowBytes)) {
+            feed++;
+            r++;
+        }
+        if(r == n) break;
+
+        // Rows r..end-1 go in one command
+        int end = r + 1, white = 0;
+        for(int i = r + 1; i < n; i++) {
+            if(!isWhite(rows + i * rowBytes, rowBytes)) {
+                end   = i + 1;
+                white = 0;
+            } else if(++white * rowBytes > overhead) {
+                break;
+            }
+        }
+
+        int first = 0, last = rowBytes - 1;
+        if(trim) {
+            findInk(rows + r * rowBytes, end - r, rowBytes, &first, &last);
+            if(first * 8 != margin) {
+                margin = first * 8;
+                writeBytes(ASCII_GS, 'L', margin & 0xFF, margin >> 8);
             }
-            for(i = rowBytes - rowBytesClipped; i>0; i--) {
-                while((c = fromStream->read()) < 0);
+        }
+        skipDots(feed);
+        feed = 0;
+
+        int width = last - first + 1;
+        uint8_t raster_command[] = {
+            ASCII_GS, 'v', '0', 0,                  // m = normal density
+            (uint8_t)width, (uint8_t)(width >> 8),
+            (uint8_t)(end - r), (uint8_t)((end - r) >> 8)
+        };
+        STAT_COMMANDS(1);
+        emit(raster_command, sizeof(raster_command));
+        if(width == rowBytes) {
+            emit(rows + r * rowBytes, (end - r) * rowBytes);
+        } else {
+            for(int i = r; i < end; i++) {
+                emit(rows + i * rowBytes + first, width);
+            }
+        }
+        r = end;
+    }
+}
+
+// GS v 0 raster bit image.  Rows are sent as they are, up to
+// maxChunkHeight rows per command (see setMaxChunkHeight()).  Rows that
+// are not already in RAM are read a few at a time.
+bool ESC_POS_Printer::printRaster(int w, int h, ESC_POS_RowSource &rows) {
+    const int maxBytes = ESC_POS_IMAGE_MAX_WIDTH / 8;
+    const int maxRows  = 24;
+    uint8_t block[maxRows * maxBytes];
+    int rowBytes = (w + 7) / 8, feed = 0, margin = 0, n;
+    bool ok = true, trim = leftJustified();
+
+    rowBytes = min(rowBytes, min(maxBytes, model.dots / 8)); // Paper width
+
+    for(int rowStart = 0; ok && (rowStart < h); rowStart += n) {
+        n = min((int)maxChunkHeight, h - rowStart);
+        const uint8_t *chunk = rows.takeRows(n, rowBytes);
+        if(!chunk) {
+            int r;
+            n = min(n, maxRows);
+            for(r = 0; r < n; r++) {
+                if(!rows.readRow(block + r * rowBytes, rowBytes)) {
+                    ok = false;
+                    break;
+                }
             }
+            n = r;
+            chunk = block;
+        }
+        rasterRows(chunk, n, rowBytes, trim, feed, margin);
+    }
+    skipDots(feed);
+    if(margin) writeBytes(ASCII_GS, 'L', 0, 0);
+
+    prevByte = '\n';
+    column   = 0;
+    endLine();
+    return ok;
+}
+
+bool ESC_POS_Printer::printImage(
+        int w, int h, const uint8_t *bitmap, int density) {
+    ESC_POS_MemoryRows rows(bitmap, (w + 7) / 8);
+    return printImage(w, h, rows, density);
+}
+
+bool ESC_POS_Printer::printImage_P(
+        int w, int h, const uint8_t *bitmap, int density) {
+    ESC_POS_MemoryRows rows(bitmap, (w + 7) / 8, true);
+    return printImage(w, h, rows, density);
+}
+
+bool ESC_POS_Printer::printImage(
+        int w, int h, Stream *fromStream, int density) {
+    ESC_POS_StreamRows rows(fromStream, (w + 7) / 8);
+    return printImage(w, h, rows, density);
+}
+
+// Images kept in the printer to be printed again without resending them
+// (see ESC_POS_ImageCache.h).  With download graphics (GS ( L) each key
+// names its own image, held in printer RAM until it is replaced, deleted
+// or the printer is reset.  Otherwise there is room for a single GS *
+// image, which every key shares.
+
+static void keyCode(uint8_t key, uint8_t *kc) {
+    kc[0] = ' ' + key / 95; // Key codes are two printable characters
+    kc[1] = ' ' + key % 95;
+}
+
+// Store a row-major bitmap under key.  Return false, sending nothing, if
+// it is too big to store.
+bool ESC_POS_Printer::storeImage(uint8_t key, int w, int h,
+        const uint8_t *bitmap, bool fromProgMem) {
+    STAT_KIND(STAT_IMAGE);
+    uint16_t rowBytes = (w + 7) / 8;
+
+    if((w <= 0) || (h <= 0) || (w > min(ESC_POS_IMAGE_MAX_WIDTH, (int)model.dots)))
+        return false;
+
+    if(model.graphicsMemory) {
+        if(h > 2304) return false;
+        uint32_t k = (uint32_t)rowBytes * h, p = k + 11;
+        uint8_t cmd[17], n = 0;
+        cmd[n++] = ASCII_GS;
+        if(p <= 0xFFFF) {
+            cmd[n++] = '(';
+            cmd[n++] = 'L';
+        } else {
+            cmd[n++] = '8';     // GS 8 L, four byte parameter count
+            cmd[n++] = 'L';
+            cmd[n++] = p;
+            cmd[n++] = p >> 8;
+            p >>= 16;
         }
+        cmd[n++] = p;
+        cmd[n++] = p >> 8;
+        cmd[n++] = 48;
+        cmd[n++] = 83;          // Define downloaded graphics, raster format
+        cmd[n++] = 48;          // Monochrome
+        keyCode(key, cmd + n);
+        n += 2;
+        cmd[n++] = 1;           // One colour
+        cmd[n++] = w;
+        cmd[n++] = w >> 8;
+        cmd[n++] = h;
+        cmd[n++] = h >> 8;
+        cmd[n++] = 49;          // Colour 1
+        STAT_COMMANDS(1);
+        emit(cmd, n);
+        if(fromProgMem) emit_P(bitmap, k);
+        else            emit(bitmap, k);
+        return true;
+    }
+
+    // GS * downloaded bit image: columns of y bytes, top byte first
+    uint8_t y = (h + 7) / 8;
+    if((rowBytes > 255) || (y > 48) || (rowBytes * y > 1536)) return false;
+    writeBytes(ASCII_GS, '*', rowBytes, y);
+    uint8_t col[48];
+    for(uint16_t x = 0; x < rowBytes * 8; x++) {
+        uint8_t mask = 0x80 >> (x & 7);
+        const uint8_t *src = bitmap + x / 8;
+        memset(col, 0, y);
+        for(int r = 0; r < h; r++, src += rowBytes) {
+            uint8_t b = fromProgMem ? pgm_read_byte(src) : *src;
+            if(b & mask) col[r >> 3] |= 0x80 >> (r & 7);
+        }
+        emit(col, y);
+    }
+    return true;
+}
+
+// Print the image stored under key; h is its height, for pacing.
+void ESC_POS_Printer::printStoredImage(uint8_t key, int h) {
+    STAT_KIND(STAT_IMAGE);
+    if(model.graphicsMemory) {
+        uint8_t cmd[] = { ASCII_GS, '(', 'L', 6, 0, 48, 85, 0, 0, 1, 1 };
+        keyCode(key, cmd + 7);
+        STAT_COMMANDS(1);
+        emit(cmd, sizeof(cmd));
+    } else {
+        writeBytes(ASCII_GS, '/', 0);
     }
+    addWork(h, 0);
     prevByte = '\n';
+    column   = 0;
+    endLine();
 }
 
-void ESC_POS_Printer::printBitmap(Stream *fromStream) {
-    uint8_t  tmp;
-    uint16_t width, height;
+// Free the printer memory of the image stored under key
+void ESC_POS_Printer::deleteStoredImage(uint8_t key) {
+    STAT_KIND(STAT_IMAGE);
+    if(model.graphicsMemory) {
+        uint8_t cmd[] = { ASCII_GS, '(', 'L', 4, 0, 48, 82, 0, 0 };
+        keyCode(key, cmd + 7);
+        STAT_COMMANDS(1);
+        emit(cmd, sizeof(cmd));
+    }
+}
+
+// Print an 8-bit grayscale image, one byte per dot (0 = black, 255 =
+// white), dithering it a row at a time on the way to the printer.
+bool ESC_POS_Printer::printGrayscale(
+        int w, int h, const uint8_t *gray, uint8_t dither, int density) {
+    ESC_POS_MemoryRows rows(gray, w);
+    ESC_POS_Dither dots(rows, w, dither);
+    return printImage(w, h, dots, density);
+}
+
+bool ESC_POS_Printer::printGrayscale(
+        int w, int h, Stream *fromStream, uint8_t dither, int density) {
+    ESC_POS_StreamRows rows(fromStream, w);
+    ESC_POS_Dither dots(rows, w, dither);
+    return printImage(w, h, dots, density);
+}
+
+// === Print queue ===
+
+// Queue committed output in buffer instead of writing it to the stream
+// straight away, and call poll() from loop() to pass it on a little at a
+// time without blocking.  The buffer should hold a whole job; if it
+// fills up, output blocks as it does without a queue.  Any output still
+// queued is written first.  setQueue(NULL, 0) goes back to blocking
+// writes.
+void ESC_POS_Printer::setQueue(uint8_t *buffer, size_t size) {
+    drain();
+    ring     = (buffer && size) ? buffer : NULL;
+    ringSize = ring ? size : 0;
+    ringHead = 0;
+}
+
+// Room in the stream's transmit buffer.  Streams that have never reported
+// any are assumed to take ESC_POS_POLL_CHUNK bytes without blocking.
+size_t ESC_POS_Printer::writeRoom() {
+    int n = stream->availableForWrite();
+    if(n > 0) {
+        spaceKnown = true;
+        return n;
+    }
+    return spaceKnown ? 0 : ESC_POS_POLL_CHUNK;
+}
+
+// Write len of the oldest queued bytes to the stream
+void ESC_POS_Printer::dequeue(size_t len) {
+    while(len > 0) {
+        size_t n = min(len, ringSize - ringHead);
+        transmit(ring + ringHead, n);
+        ringHead = (ringHead + n) % ringSize;
+        ringLen -= n;
+        len     -= n;
+    }
+}
+
+// Write out pending real-time commands and at least len queued bytes (all
+// of them by default), blocking as long as it takes.
+void ESC_POS_Printer::drain(size_t len) {
+    if(priorityLen) {
+        stream->write(priority, priorityLen);
+        priorityLen = 0;
+    }
+    if(ring) dequeue(min(len, ringLen));
+}
+
+// Pass as much queued output to the stream as it can take without
+// blocking, real-time commands first, and pick up any status the printer
+// has sent.  Call it often, e.g. from loop().
+// Returns the number of bytes written.
+size_t ESC_POS_Printer::poll() {
+    size_t room = writeRoom(), sent = 0;
+
+    updateStatus();
+
+    if(priorityLen && room) {
+        sent = min((size_t)priorityLen, room);
+        stream->write(priority, sent);
+        priorityLen -= sent;
+        memmove(priority, priority + sent, priorityLen);
+        room -= sent;
+    }
+    if(ring && room) {
+        size_t n = min(ringLen, min(room, paceRoom()));
+        dequeue(n);
+        sent += n;
+    }
+    return sent;
+}
+
+// Bytes waiting to be written by poll().  Output joins the queue when it
+// is committed.
+size_t ESC_POS_Printer::queued() {
+    return priorityLen + ringLen;
+}
+
+// Bytes that can be committed without blocking, (size_t)-1 without a
+// queue, where every write blocks until done
+size_t ESC_POS_Printer::queueRoom() {
+    return ring ? ringSize - ringLen : (size_t)-1;
+}
+
+// Throw away output not yet written to the stream and have the printer
+// clear its own buffers (DLE DC4 8), e.g. to give up on a job when the
+// paper runs out.  A command cut short is cleared with it.
+void ESC_POS_Printer::cancel() {
+    static const uint8_t clearBuffers[] = {
+        ASCII_DLE, ASCII_DC4, 8, 1, 3, 20, 1, 6, 2, 8
+    };
+
+    outLen   = 0;
+    ringHead = 0;
+    ringLen  = 0;
+    work     = 0;
+    backlog  = 0;
+    stream->write(clearBuffers, sizeof(clearBuffers));
+    invalidateState();
+    prevByte = '\n';
+    column   = 0;
+}
 
-    tmp    =  fromStream->read();
-    width  = (fromStream->read() << 8) + tmp;
+// Send a real-time command (DLE EOT, DLE ENQ, DLE DC4 and so on) ahead
+// of any queued output.  The printer acts on these as soon as they
+// arrive, even in the middle of another command.  Without a queue the
+// command is written at once.  Returns false if the priority lane is
+// full; poll() to empty it.
+bool ESC_POS_Printer::realtime(const uint8_t *cmd, uint8_t len) {
+    if(ring && priorityLen + len > ESC_POS_PRIORITY_SIZE) return false;
+    STAT_COMMANDS(1);
+    STAT_BYTES(len);
+    if(!ring) {
+        stream->write(cmd, len);
+        return true;
+    }
+    memcpy(priority + priorityLen, cmd, len);
+    priorityLen += len;
+    return true;
+}
 
-    tmp    =  fromStream->read();
-    height = (fromStream->read() << 8) + tmp;
+// === Flow control and pacing ===
+
+// Serial printers have a small receive buffer and print far slower than
+// data arrives, so output has to be held back or bytes are lost.  The
+// printer can say when to stop: XON/XOFF bytes (setXonXoff()) or a busy
+// line on a pin (setBusyPin()).  Without either, setPacing() estimates how
+// full the printer's buffer is from the baud rate and the printing times
+// given to setTimes(), and never sends more than the buffer holds.  USB
+// printers handshake by themselves and need none of this.
+
+// Pace output for a printer at baud on a buffer of bufferSize bytes.
+// baud 0 turns pacing off.
+void ESC_POS_Printer::setPacing(unsigned long baud, size_t bufferSize) {
+    // Bits per byte: start, 8 data, stop, and one more as a margin
+    byteTime      = baud ? ((11L * 1000000L) + (baud / 2)) / baud : 0;
+    printerBuffer = max(bufferSize, (size_t)1);
+    backlog       = 0;
+    paceTime      = micros();
+}
 
-    printBitmap(width, height, fromStream);
+// Microseconds the printer takes to print and to feed one row of dots.
+// Used with setPacing() to estimate when there is room again; with no
+// baud rate set, output simply waits until the last line has printed.
+void ESC_POS_Printer::setTimes(unsigned long p, unsigned long f) {
+    dotPrintTime = p;
+    dotFeedTime  = f;
+    backlog      = 0;
+    paceTime     = micros();
+}
+
+// Stop sending when the printer sends XOFF, until it sends XON.  The
+// bytes are picked up by updateStatus().
+void ESC_POS_Printer::setXonXoff(bool on) {
+    xonXoff = on;
+    xoff    = false;
+}
+
+// Hold output while pin reads busyLevel (the printer's BUSY or DTR line).
+// pin -1 turns it off.
+void ESC_POS_Printer::setBusyPin(int pin, uint8_t level) {
+    busyPin   = pin;
+    busyLevel = level;
+    if(pin >= 0) pinMode(pin, INPUT);
+}
+
+bool ESC_POS_Printer::paused() {
+    return (xonXoff && xoff) ||
+        ((busyPin >= 0) && (digitalRead(busyPin) == busyLevel));
+}
+
+// Add the time it takes to print and feed rows of dots to the work the
+// printer has queued.  It counts once the output is sent.
+void ESC_POS_Printer::addWork(unsigned int printDots, unsigned int feedDots) {
+    addTime(printDots * dotPrintTime + feedDots * dotFeedTime);
+    STAT_ROWS(printDots, feedDots);
+}
+
+// Same in microseconds.  Captured output is timed apart, for replay().
+void ESC_POS_Printer::addTime(unsigned long t) {
+    if(captureTo) captureWork += t;
+    if(!captureTo || capturePrint) work += t;
+}
+
+// Bytes the printer can take now, (size_t)-1 when there is no limit
+size_t ESC_POS_Printer::paceRoom() {
+    if(paused()) return 0;
+    if(!byteTime && !dotPrintTime && !dotFeedTime) return (size_t)-1;
+
+    unsigned long now = micros(), elapsed = now - paceTime;
+    paceTime = now;
+    backlog  = (elapsed < backlog) ? backlog - elapsed : 0;
+
+    unsigned long limit = printerBuffer * byteTime;
+    if(backlog > limit) return 0;
+    if(!byteTime) return (size_t)-1;
+    return (limit - backlog) / byteTime;
+}
+
+// No pacing or flow control, so output can go straight to the stream
+bool ESC_POS_Printer::unpaced() {
+    return !byteTime && !dotPrintTime && !dotFeedTime && !xonXoff &&
+        (busyPin < 0);
+}
+
+// Write to the stream, waiting for flow control and buffer room.  With
+// XON/XOFF, incoming bytes are read before every write and output goes
+// in ESC_POS_POLL_CHUNK pieces, so an XOFF stops it within a chunk.
+void ESC_POS_Printer::transmit(const uint8_t *buf, size_t len) {
+    if(unpaced()) {
+        stream->write(buf, len);
+        return;
+    }
+    while(len > 0) {
+        size_t n;
+        updateStatus(); // XOFF and XON arrive here
+        while((n = paceRoom()) == 0) {
+            yield();
+            updateStatus();
+        }
+        n = min(n, len);
+        if(xonXoff) n = min(n, (size_t)ESC_POS_POLL_CHUNK);
+        stream->write(buf, n);
+        backlog += n * byteTime + work;
+        work     = 0;
+        buf     += n;
+        len     -= n;
+    }
+}
+
+// === Printer status ===
+
+// The printer reports its status in two ways, both handled without
+// waiting: replies to DLE EOT real-time requests (requestStatus()) and
+// Automatic Status Back messages sent whenever something changes
+// (setStatusBack()).  Incoming bytes are parsed by updateStatus(), which
+// poll() and status() also call.
+
+// Ask the printer to send its status on its own whenever one of the
+// events (ASB_DRAWER, ASB_ONLINE, ASB_ERROR, ASB_PAPER) changes; it
+// also sends the current status right away.  0 turns it off.
+void ESC_POS_Printer::setStatusBack(uint8_t events) {
+    if(!model.statusBack) return; // Use requestStatus()
+    asbEvents = events & ASB_ALL;
+    writeBytes(ASCII_GS, 'a', asbEvents);
+    endLine();
+}
+
+void ESC_POS_Printer::onStatusChange(ESC_POS_StatusCallback callback) {
+    statusCallback = callback;
+}
+
+// Request one DLE EOT status byte: 1 printer, 2 offline cause, 3 error
+// cause, 4 paper roll sensor.  Sent ahead of queued output; the reply is
+// picked up by updateStatus().  A request still waiting for its reply
+// is not sent again, unless ESC_POS_STATUS_TIMEOUT has passed without
+// one.  Returns false if four requests are waiting.
+bool ESC_POS_Printer::requestStatus(uint8_t n) {
+    if((n < 1) || (n > 4)) return false;
+    expireStatus();
+    if(memchr(pendingStatus, n, pendingCount)) return true;
+    if(pendingCount >= sizeof(pendingStatus)) return false;
+    uint8_t cmd[] = { ASCII_DLE, ASCII_EOT, n };
+    if(!realtime(cmd, sizeof(cmd))) return false;
+    pendingTime[pendingCount]     = millis();
+    pendingStatus[pendingCount++] = n;
+    return true;
+}
+
+// Give up on requests that have waited too long for a reply, so a late
+// or lost reply is not taken as the answer to a newer request
+void ESC_POS_Printer::expireStatus() {
+    uint8_t n = 0;
+    unsigned long now = millis();
+
+    while((n < pendingCount) &&
+            (now - pendingTime[n] >= ESC_POS_STATUS_TIMEOUT)) n++;
+    if(!n) return;
+    pendingCount -= n;
+    memmove(pendingStatus, pendingStatus + n, pendingCount);
+    memmove(pendingTime, pendingTime + n, pendingCount * sizeof(pendingTime[0]));
+}
+
+// Status flags as last reported, with STATUS_KNOWN set once anything has
+// been received.  Does not wait for the printer.
+uint8_t ESC_POS_Printer::status() {
+    updateStatus();
+    return statusFlags;
+}
+
+// Parse whatever the printer has sent back so far
+void ESC_POS_Printer::updateStatus() {
+    expireStatus();
+    while(stream->available() > 0) {
+        int c = stream->read();
+        if(c < 0) break;
+        statusByte(c);
+    }
+}
+
+// Replace the flags in mask and tell the callback what changed
+void ESC_POS_Printer::setStatus(uint8_t mask, uint8_t flags) {
+    uint8_t old = statusFlags;
+    statusFlags = (statusFlags & ~mask) | (flags & mask) | STATUS_KNOWN;
+    if(statusCallback && (statusFlags != old))
+        statusCallback(statusFlags, statusFlags ^ old);
+}
+
+// A DLE EOT reply is one byte 0xx1xx10.  An ASB message is four bytes,
+// the first 0xx1xx00 and the rest 0xx0xxxx.  XON and XOFF may turn up
+// anywhere.
+void ESC_POS_Printer::statusByte(uint8_t c) {
+    uint8_t flags = 0;
+
+    if((c == 0x11) || (c == 0x13)) { // XON, XOFF
+        xoff = (c == 0x13);
+        return;
+    }
+
+    if(asbIndex > 0) {
+        if((c & 0x90) == 0) {
+            if(asbIndex < sizeof(asbBytes)) asbBytes[asbIndex] = c;
+            if(++asbIndex < 4) return;
+            asbIndex = 0;
+            if(asbBytes[0] & 0x04) flags |= STATUS_DRAWER;
+            if(asbBytes[0] & 0x08) flags |= STATUS_OFFLINE;
+            if(asbBytes[0] & 0x20) flags |= STATUS_COVER_OPEN;
+            if(asbBytes[0] & 0x40) flags |= STATUS_FEED_BUTTON;
+            if(asbBytes[1] & 0x6C) flags |= STATUS_ERROR;
+            if(asbBytes[2] & 0x03) flags |= STATUS_PAPER_NEAR_END;
+            if(asbBytes[2] & 0x0C) flags |= STATUS_PAPER_OUT;
+            paperKnown = true;
+            setStatus((uint8_t)~STATUS_KNOWN, flags);
+            return;
+        }
+        asbIndex = 0; // Not ASB after all, look at c afresh
+    }
+
+    if((c & 0x93) == 0x10) {        // Start of ASB
+        asbBytes[0] = c;
+        asbIndex    = 1;
+    } else if(((c & 0x93) == 0x12) && pendingCount) { // DLE EOT reply
+        uint8_t n = pendingStatus[0];
+        memmove(pendingStatus, pendingStatus + 1, --pendingCount);
+        memmove(pendingTime, pendingTime + 1, pendingCount * sizeof(pendingTime[0]));
+        switch(n) {
+            case 1: // Printer status
+                if(c & 0x04) flags |= STATUS_DRAWER;
+                if(c & 0x08) flags |= STATUS_OFFLINE;
+                if(c & 0x40) flags |= STATUS_FEED_BUTTON;
+                setStatus(STATUS_DRAWER | STATUS_OFFLINE | STATUS_FEED_BUTTON, flags);
+                break;
+            case 2: // Offline cause
+                if(c & 0x04) flags |= STATUS_COVER_OPEN;
+                if(c & 0x08) flags |= STATUS_FEED_BUTTON;
+                if(c & 0x40) flags |= STATUS_ERROR;
+                setStatus(STATUS_COVER_OPEN | STATUS_FEED_BUTTON | STATUS_ERROR, flags);
+                break;
+            case 3: // Error cause
+                if(c & 0x6C) flags |= STATUS_ERROR;
+                setStatus(STATUS_ERROR, flags);
+                break;
+            case 4: // Paper roll sensor
+                if(c & 0x0C) flags |= STATUS_PAPER_NEAR_END;
+                if(c & 0x60) flags |= STATUS_PAPER_OUT;
+                paperKnown = true;
+                setStatus(STATUS_PAPER_NEAR_END | STATUS_PAPER_OUT, flags);
+                break;
+        }
+    }
+}
+
+// === QR codes ===
+
+// Use the printer's own QR code command (the default when the profile
+// has GS ( k), or encode QR codes here and print them as graphics.
+void ESC_POS_Printer::setQRCodeNative(bool on) {
+    qrNative = on;
+}
+
+bool ESC_POS_Printer::printQRCode(
+        const char *text, uint8_t moduleSize, char ecLevel) {
+    return printQRCode((const uint8_t *)text, strlen(text), moduleSize, ecLevel);
+}
+
+// Print len bytes of data as a QR code with modules moduleSize dots wide
+// and error correction level 'L', 'M', 'Q' or 'H'.  Returns false if the
+// data is too long.
+bool ESC_POS_Printer::printQRCode(
+        const uint8_t *data, size_t len, uint8_t moduleSize, char ecLevel) {
+    STAT_KIND(STAT_IMAGE);
+    if(moduleSize < 1) moduleSize = 1;
+    if(moduleSize > 16) moduleSize = 16;
+
+    if(!model.qrCode || !qrNative) {
+        ESC_POS_QRCode qr;
+        if(!qr.encode(data, len, ecLevel)) return false;
+        // Shrink the modules until the symbol fits the paper
+        int paper = min(ESC_POS_IMAGE_MAX_WIDTH, (int)model.dots);
+        while((moduleSize > 1) && (qr.render(moduleSize) > paper))
+            moduleSize--;
+        int dots = qr.render(moduleSize);
+        return printImage(dots, dots, qr, BITMAP_24DOT);
+    }
+
+    // GS ( k <Function 180>: store the data at most 7089 bytes long
+    if(len > 7089) return false;
+    uint8_t level;
+    switch(toupper(ecLevel)) {
+        case 'L': level = '0'; break;
+        default:  level = '1'; break;
+        case 'Q': level = '2'; break;
+        case 'H': level = '3'; break;
+    }
+    command<ESC_POS_Seq<0, ASCII_GS, '(', 'k', 4, 0, '1', 'A', '2', 0> >(); // <Function 165>: model 2
+    uint8_t setup[] = {
+        ASCII_GS, '(', 'k', 3, 0, '1', 'C', moduleSize, // <Function 167>
+        ASCII_GS, '(', 'k', 3, 0, '1', 'E', level,      // <Function 169>
+        ASCII_GS, '(', 'k', (uint8_t)((len + 3) & 0xFF), (uint8_t)((len + 3) >> 8),
+            '1', 'P', '0'                               // <Function 180>
+    };
+    STAT_COMMANDS(3);
+    emit(setup, sizeof(setup));
+    emit(data, len);
+    command<ESC_POS_Seq<0, ASCII_GS, '(', 'k', 3, 0, '1', 'Q', '0'> >(); // <Function 181>
+
+    prevByte = '\n';
+    column   = 0;
+    endLine();
+    return true;
 }
 
 // Take the printer offline. Print commands sent after this will be
 // ignored until 'online' is called.
 void ESC_POS_Printer::offline(){
-    writeBytes(ASCII_ESC, '=', 0);
+    writeMode(MODE_ONLINE, ASCII_ESC, '=', 0);
 }
 
 // Take the printer back online. Subsequent print commands will be obeyed.
 void ESC_POS_Printer::online(){
-    writeBytes(ASCII_ESC, '=', 1);
+    writeMode(MODE_ONLINE, ASCII_ESC, '=', 1);
 }
 
 // Put the printer into a low-energy state immediately.
@@ -476,6 +1895,7 @@ void ESC_POS_Printer::sleep() {
 // of seconds.
 void ESC_POS_Printer::sleepAfter(uint16_t seconds) {
     writeBytes(ASCII_ESC, '8', seconds, seconds >> 8);
+    commit();
 }
 
 // Wake the printer from a low-energy state.
@@ -485,21 +1905,21 @@ void ESC_POS_Printer::wake() {
 // Check the status of the paper using the printer's self reporting
 // ability.  Returns true for paper, false for no paper.
 // Might not work on all printers!
+// Answers from the cached status (see status()) and asks again for next
+// time.  Only the first answer is waited for, up to ESC_POS_STATUS_TIMEOUT;
+// with no answer at all, assumes paper.
 bool ESC_POS_Printer::hasPaper() {
-    //  writeBytes(ASCII_DLE, ASCII_EOT, 4);
-    writeBytes(ASCII_GS, 'r', 1);
-    //  writeBytes(ASCII_ESC, 'v');
-
-    int status = 0;
-    for(uint8_t i=0; i<10; i++) {
-        if(stream->available()) {
-            status = stream->read();
-            break;
+    uint8_t flags = status();
+    if(!(asbEvents & ASB_PAPER)) {
+        requestStatus(4);
+        // Until the request is answered or expires (see expireStatus())
+        while(!paperKnown && memchr(pendingStatus, 4, pendingCount)) {
+            if(ring) poll();
+            yield();
+            flags = status();
         }
-        delay(100);
     }
-
-    return !(status & 0b00001100);
+    return !(flags & STATUS_PAPER_OUT);
 }
 
 void ESC_POS_Printer::setLineHeight(int val) {
@@ -510,27 +1930,81 @@ void ESC_POS_Printer::setLineHeight(int val) {
     // when setting line height, making this more akin to inter-line
     // spacing.  Default line spacing is 30 (char height of 24, line
     // spacing of 6).
-    writeBytes(ASCII_ESC, '3', val);
+    writeMode(MODE_LINE_HEIGHT, ASCII_ESC, '3', val);
 }
 
+// Most rows sent in one raster or DC2 * bitmap command.  Size it to the
+// printer's receive buffer, e.g. a 4K buffer holds 85 rows of 384 dots.
 void ESC_POS_Printer::setMaxChunkHeight(int val) {
+    if(val < 1) val = 1;
+    if(val > 2303) val = 2303; // GS v 0 limit
+    maxChunkHeight = val;
 }
 
 // Alters some chars in ASCII 0x23-0x7E range; see datasheet
 void ESC_POS_Printer::setCharset(uint8_t val) {
-    writeBytes(ASCII_ESC, 'R', val);
+    writeMode(MODE_CHARSET, ASCII_ESC, 'R', val);
 }
 
 // Selects alt symbols for 'upper' ASCII values 0x80-0xFF
 void ESC_POS_Printer::setCodePage(uint8_t val) {
-    writeBytes(ASCII_ESC, 't', val);
+    writeMode(MODE_CODE_PAGE, ASCII_ESC, 't', val);
+}
+
+// Send commands and large data blocks together through gather, which
+// should be the printer's stream, e.g. an ESC_POS_FdStream.  It is only
+// used while output goes straight to the stream: no queue and no pacing.
+void ESC_POS_Printer::setGather(ESC_POS_Gather *gather) {
+    commit();
+    this->gather = gather;
+}
+
+// Pass all printed text through encoder, e.g. an ESC_POS_UTF8 to print
+// UTF-8 strings.  NULL sends text to the printer as it is.
+void ESC_POS_Printer::setEncoder(ESC_POS_Encoder *encoder) {
+    this->encoder = encoder;
+}
+
+ESC_POS_Encoder *ESC_POS_Printer::textEncoder() {
+    return encoder;
 }
 
 void ESC_POS_Printer::tab() {
+    STAT_KIND(STAT_TEXT);
     writeBytes(ASCII_TAB);
-    column = (column + 4) & 0b11111100;
+    if(tabCount == TABS_DEFAULT) {
+        column = (column + 8) & ~7;
+        return;
+    }
+    for(uint8_t i = 0; i < tabCount; i++) {
+        if(tabStops[i] > column) {
+            column = tabStops[i];
+            break;
+        }
+    }
+}
+
+// Set tab stops (ESC D) at the given columns, in increasing order.  Only
+// the first ESC_POS_TAB_STOPS are kept; count 0 clears them all.
+void ESC_POS_Printer::setTabStops(const uint8_t *columns, uint8_t count) {
+    writeBytes(ASCII_ESC, 'D');
+    tabCount = 0;
+    for(uint8_t i = 0; i < count && tabCount < ESC_POS_TAB_STOPS; i++) {
+        if(tabCount && (columns[i] <= tabStops[tabCount - 1])) continue;
+        tabStops[tabCount++] = columns[i];
+        emit(columns[i]);
+    }
+    emit(0);
+}
+
+// Move to dots from the left margin (ESC $) to print the next character
+// there, e.g. to line up columns without padding them with spaces.
+void ESC_POS_Printer::setPosition(uint16_t dots) {
+    STAT_KIND(STAT_TEXT);
+    writeBytes(ASCII_ESC, '$', dots & 0xFF, dots >> 8);
+    column = dots / (model.dots / model.columns);
 }
 
 void ESC_POS_Printer::setCharSpacing(int spacing) {
-    writeBytes(ASCII_ESC, ' ', spacing);
+    writeMode(MODE_CHAR_SPACING, ASCII_ESC, ' ', spacing);
 }
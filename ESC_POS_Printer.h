@@ -19,6 +19,11 @@
 #define ESC_POS_PRINTER_H
 
 #include "Arduino.h"
+#include "ESC_POS_Profile.h"
+#include "ESC_POS_Image.h"
+#include "ESC_POS_QRCode.h"
+#include "ESC_POS_Barcode.h"
+#include "ESC_POS_Stats.h"
 
 // Barcode types and charsets
 #define UPC_A              65
@@ -112,20 +117,119 @@
 #define CODEPAGE_CP856       46
 #define CODEPAGE_CP874       47
 
+// Graphics modes for printImage().  The values match the density
+// argument of printBitmap().
+#define BITMAP_8DOT   1 // ESC * 8-dot bands, single density
+#define BITMAP_24DOT  2 // ESC * 24-dot bands, double density
+#define BITMAP_RASTER 3 // GS v 0 raster, rows sent as they are (24-dot bands
+                        // if the profile has no GS v 0)
+
+// Size in bytes of the output buffer.  Text and commands are collected
+// here and handed to the Stream in one write when the buffer fills, on
+// commit(), at the end of each printed line (unless auto commit is off)
+// and before anything is read back from the printer.
+#ifndef ESC_POS_BUFFER_SIZE
+#define ESC_POS_BUFFER_SIZE 128
+#endif
+
+// Printer status flags returned by status() and passed to the status
+// callback.  Each comes from DLE EOT replies or Automatic Status Back.
+#define STATUS_OFFLINE        (1 << 0)
+#define STATUS_COVER_OPEN     (1 << 1)
+#define STATUS_FEED_BUTTON    (1 << 2) // Paper being fed by the button
+#define STATUS_PAPER_NEAR_END (1 << 3)
+#define STATUS_PAPER_OUT      (1 << 4)
+#define STATUS_ERROR          (1 << 5) // Cutter, mechanical or other error
+#define STATUS_DRAWER         (1 << 6) // Drawer kick-out connector pin 3 high
+#define STATUS_KNOWN          (1 << 7) // Some status has been received
+
+// Automatic Status Back (GS a) events for setStatusBack()
+#define ASB_DRAWER  (1 << 0)
+#define ASB_ONLINE  (1 << 1)
+#define ASB_ERROR   (1 << 2)
+#define ASB_PAPER   (1 << 3)
+#define ASB_ALL     0x0F
+
+// Called with the new status flags and the flags that changed
+typedef void (*ESC_POS_StatusCallback)(uint8_t status, uint8_t changed);
+
+// Most tab stops setTabStops() keeps track of
+#ifndef ESC_POS_TAB_STOPS
+#define ESC_POS_TAB_STOPS 8
+#endif
+
+// Bytes written by poll() to a stream whose availableForWrite() has never
+// reported free space (many streams always return 0), and most bytes
+// written at once with XON/XOFF flow control on.
+#ifndef ESC_POS_POLL_CHUNK
+#define ESC_POS_POLL_CHUNK 32
+#endif
+
+// Milliseconds to wait for the reply to a DLE EOT request before it is
+// given up, e.g. because the printer was off or the request was lost.
+#ifndef ESC_POS_STATUS_TIMEOUT
+#define ESC_POS_STATUS_TIMEOUT 1000
+#endif
+
+// Size in bytes of the priority lane for real-time commands (DLE EOT,
+// DLE ENQ, DLE DC4) that must not wait behind the print queue.
+#ifndef ESC_POS_PRIORITY_SIZE
+#define ESC_POS_PRIORITY_SIZE 8
+#endif
+
+class ESC_POS_Printer;
+
+// Base class for text encoders set with setEncoder(), e.g. ESC_POS_UTF8.
+// Printed text is handed to the encoder, which writes the printer's bytes
+// back through the same printer.
+class ESC_POS_Encoder {
+
+    public:
+
+        virtual void
+            write(ESC_POS_Printer &printer, const uint8_t *text, size_t len) = 0;
+
+        // The printer was reset (ESC @), losing its code page and any
+        // downloaded characters.
+        virtual void
+            reset() {}
+};
+
+// Streams that can send two buffers in one call, such as
+// ESC_POS_FdStream with writev(), derive from this as well.  Given to
+// setGather(), a command and a block of data too big for the output
+// buffer (a bitmap band, say) go out in one write without being copied
+// together.
+class ESC_POS_Gather {
+
+    public:
+
+        virtual size_t
+            writeGather(const uint8_t *a, size_t aLen,
+                    const uint8_t *b, size_t bLen) = 0;
+};
+
 class ESC_POS_Printer : public Print {
 
     public:
 
         // IMPORTANT: constructor syntax has changed from prior versions
-        // of this library.  Please see notes in the example code!
-        ESC_POS_Printer(Stream *s=&Serial);
+        // of this library.  Please see notes in the example code!  With
+        // ESC_POS_PROFILE_FIXED the profile must be ESC_POS_PROFILE.
+        ESC_POS_Printer(Stream *s=&Serial,
+                const ESC_POS_Profile &profile=ESC_POS_PROFILE);
 
         size_t
-            write(uint8_t c);
+            write(uint8_t c),
+            write(const uint8_t *buffer, size_t size);
+        using Print::write; // write(const char *) etc.
         void
             begin(),
             boldOff(),
             boldOn(),
+            cancel(),
+            commit(),
+            cut(bool partial=false),
             doubleHeightOff(),
             doubleHeightOn(),
             doubleWidthOff(),
@@ -133,31 +237,48 @@ class ESC_POS_Printer : public Print {
             feed(uint8_t x=1),
             feedRows(uint8_t),
             flush(),
+            invalidateState(),
             inverseOff(),
             inverseOn(),
             justify(char value),
             offline(),
             online(),
-            printBarcode(const char *text, uint8_t type),
             printBitmap(int w, int h, const uint8_t *bitmap, int density=1),
             printBitmap_P(int w, int h, const uint8_t *bitmap, int density=1),
             printBitmap(int w, int h, const uint8_t *bitmap, bool fromProgMem=true),
-            printBitmap(int w, int h, Stream *fromStream),
-            printBitmap(Stream *fromStream),
             normal(),
+            printStoredImage(uint8_t key, int h),
+            deleteStoredImage(uint8_t key),
+            replay(const uint8_t *data, size_t len, unsigned long work=0),
             reset(),
+            setAutoCommit(bool on=true),
             setBarcodeHeight(uint8_t val=50),
+            setBarcodeText(uint8_t position=2),
+            setBarcodeWidth(uint8_t val=3),
             setCharSpacing(int spacing=0),
             setCharset(uint8_t val=0),
             setCodePage(uint8_t val=0),
             setDefault(),
+            setEncoder(ESC_POS_Encoder *encoder),
+            setGather(ESC_POS_Gather *gather),
             setLineHeight(int val=30),
             setMaxChunkHeight(int val=256),
+            setQRCodeNative(bool on=true),
+            setQueue(uint8_t *buffer, size_t size),
+            setPacing(unsigned long baud, size_t bufferSize=4096),
+            setPosition(uint16_t dots),
+            setTabStops(const uint8_t *columns, uint8_t count),
+            setXonXoff(bool on=true),
+            setBusyPin(int pin, uint8_t busyLevel=HIGH),
+            setStatusBack(uint8_t events=ASB_ALL),
+            onStatusChange(ESC_POS_StatusCallback callback),
+            updateStatus(),
             setSize(char value),
             setSize(uint8_t height, uint8_t width),
             setTimes(unsigned long, unsigned long),
             sleep(),
             sleepAfter(uint16_t seconds),
+            startCapture(Print *to, bool print=true),
             strikeOff(),
             strikeOn(),
             tab(),
@@ -167,14 +288,97 @@ class ESC_POS_Printer : public Print {
             underlineOn(uint8_t weight=1),
             upsideDownOff(),
             upsideDownOn(),
-            wake();
+            wake(),
+            writeCommands(const uint8_t *cmds, size_t len, uint16_t modes=0xFFFF),
+            writeCommands_P(const uint8_t *cmds, size_t len, uint16_t modes=0xFFFF);
         bool
-            hasPaper();
+            hasPaper(),
+            printBarcode(const char *text, uint8_t type),
+            printBitmap(int w, int h, Stream *fromStream),
+            printBitmap(Stream *fromStream),
+            printImage(int w, int h, const uint8_t *bitmap, int density=BITMAP_8DOT),
+            printImage_P(int w, int h, const uint8_t *bitmap, int density=BITMAP_8DOT),
+            printImage(int w, int h, Stream *fromStream, int density=BITMAP_8DOT),
+            printImage(int w, int h, ESC_POS_RowSource &rows, int density=BITMAP_8DOT),
+            printGrayscale(int w, int h, const uint8_t *gray,
+                    uint8_t dither=DITHER_FLOYD_STEINBERG, int density=BITMAP_RASTER),
+            printGrayscale(int w, int h, Stream *fromStream,
+                    uint8_t dither=DITHER_FLOYD_STEINBERG, int density=BITMAP_RASTER),
+            printQRCode(const char *text, uint8_t moduleSize=4, char ecLevel='M'),
+            printQRCode(const uint8_t *data, size_t len, uint8_t moduleSize=4,
+                    char ecLevel='M'),
+            realtime(const uint8_t *cmd, uint8_t len),
+            replay(Stream *from, size_t len, unsigned long work=0),
+            requestStatus(uint8_t n=1),
+            storeImage(uint8_t key, int w, int h, const uint8_t *bitmap,
+                    bool fromProgMem=false);
+        uint8_t
+            status();
+        char
+            justification();
+        uint16_t
+            resetCount();
+        const ESC_POS_Profile &
+            profile();
+        // The encoder given to setEncoder(), NULL if text goes out as it is
+        ESC_POS_Encoder *
+            textEncoder();
+        unsigned long
+            endCapture();
+        size_t
+            poll(),
+            queued(),
+            queueRoom();
+
+        // Printer settings tracked so unchanged ones are not sent again;
+        // command sequences name the ones they change (ESC_POS_Commands.h)
+        enum {
+            MODE_PRINT,         // ESC !
+            MODE_JUSTIFY,       // ESC a
+            MODE_BOLD,          // ESC E
+            MODE_UNDERLINE,     // ESC -
+            MODE_STRIKE,        // ESC G
+            MODE_INVERSE,       // GS B
+            MODE_UPSIDE_DOWN,   // ESC {
+            MODE_LINE_HEIGHT,   // ESC 3
+            MODE_CHARSET,       // ESC R
+            MODE_CODE_PAGE,     // ESC t
+            MODE_CHAR_SPACING,  // ESC SP
+            MODE_SIZE,          // GS !
+            MODE_ONLINE,        // ESC =
+            MODE_BARCODE_TEXT,  // GS H
+            MODE_BARCODE_WIDTH, // GS w
+            MODE_COUNT
+        };
+
+#if ESC_POS_STATS
+        // Output counts (see ESC_POS_Stats.h) since the printer object was
+        // made, and since the last startJob()
+        const ESC_POS_Stats &
+            stats();
+        ESC_POS_Stats
+            jobStats();
+        void
+            startJob();
+#endif
+
+        // Send a sequence built with ESC_POS_Commands.h
+        template<class Seq>
+        void command() {
+            writeCommands_P(Seq::data, Seq::size, Seq::modes);
+        }
 
     private:
 
         Stream
             *stream;
+#if ESC_POS_PROFILE_FIXED
+        static constexpr ESC_POS_Profile
+            model = ESC_POS_PROFILE; // What every printer can do
+#else
+        ESC_POS_Profile
+            model;         // What the printer can do
+#endif
         uint8_t
             printMode,
             prevByte,      // Last character issued to printer
@@ -183,12 +387,131 @@ class ESC_POS_Printer : public Print {
             charHeight,    // Height of characters, in 'dots'
             lineSpacing,   // Inter-line spacing (not line height), in dots
             barcodeHeight, // Barcode height in dots, not including text
-            maxChunkHeight;
+            barcodeText,   // Where the human readable text goes (GS H)
+            barcodeWidth,  // Module width in dots (GS w)
+            tabStops[ESC_POS_TAB_STOPS], // Columns set by setTabStops()
+            tabCount,      // Stops in tabStops, or the default every 8 columns
+            outBuf[ESC_POS_BUFFER_SIZE]; // Bytes not yet sent to stream
+        uint16_t
+            maxChunkHeight, // Most bitmap rows sent in one command
+            outLen;        // Number of bytes in outBuf
+        ESC_POS_Encoder
+            *encoder;      // Text goes through this if set
+        ESC_POS_Gather
+            *gather;       // The stream, if it takes two buffers at once
+        bool
+            encoding,      // Encoder is writing, so its text goes straight out
+            autoCommit,    // Commit at every end of line
+            qrNative,      // Printer draws QR codes itself (GS ( k)
+            spaceKnown,    // Stream has reported availableForWrite()
+            paperKnown;    // The paper sensor has been heard from
+
+        // Print queue, see setQueue().  Committed output waits in the ring
+        // until poll() hands it to the stream; priority[] goes first.
+        uint8_t
+            *ring,
+            priority[ESC_POS_PRIORITY_SIZE],
+            priorityLen;
+        size_t
+            ringSize,
+            ringHead,      // Oldest byte in ring
+            ringLen;       // Bytes waiting in ring
+
+        // Printer status, see status()
+        uint8_t
+            statusFlags,
+            asbEvents,     // GS a setting, restored after ESC @
+            asbIndex,      // Bytes of an ASB message received so far
+            asbBytes[3],
+            pendingStatus[4], // DLE EOT requests awaiting replies, oldest first
+            pendingCount;
+        unsigned long
+            pendingTime[4]; // millis() when each request was made
+        ESC_POS_StatusCallback
+            statusCallback;
+
+        // Flow control and pacing, see setPacing().  backlog estimates how
+        // long the printer will take to get through what it has been sent.
+        unsigned long
+            byteTime,      // Microseconds per byte at the printer's baud rate
+            dotPrintTime,  // Microseconds to print one row of dots
+            dotFeedTime,   // Microseconds to feed one row of dots
+            work,          // Printing time of output not yet sent
+            backlog,       // Microseconds of work the printer holds
+            paceTime;      // micros() when backlog was brought up to date
+        size_t
+            printerBuffer; // Printer's receive buffer in bytes
+        int8_t
+            busyPin;       // -1 if none
+        uint8_t
+            busyLevel;
+        bool
+            xonXoff,
+            xoff;          // Printer sent XOFF and no XON since
+
+        // Capture, see startCapture()
+        Print
+            *captureTo;
+        unsigned long
+            captureWork;   // Printing time of the captured output
+        bool
+            capturePrint;  // Captured output is printed as well
+
+#if ESC_POS_STATS
+        ESC_POS_Stats
+            total,
+            jobStart;      // total when the job started
+        uint8_t
+            statKind;      // STAT_* of the output being made
+#endif
+
+        // Modes the printer is known to be in, so commands that would not
+        // change anything can be skipped.  A mode is only trusted while
+        // its bit is set in shadowValid.
+        uint8_t
+            shadow[MODE_COUNT];
+        uint16_t
+            shadowValid,
+            resets;        // Times the printer may have lost stored data
+        void
+            writeMode(uint8_t mode, uint8_t a, uint8_t b, uint8_t val),
+            forgetMode(uint8_t mode);
+        bool
+            leftJustified(),
+            printBands(int w, int h, ESC_POS_RowSource &rows, int density),
+            printRaster(int w, int h, ESC_POS_RowSource &rows);
+        size_t
+            emitFrom(Stream *s, size_t len, bool keep),
+            writeRoom(),
+            paceRoom();
+        bool
+            paused(),
+            unpaced();
+        void
+            transmit(const uint8_t *buf, size_t len),
+            addWork(unsigned int printDots, unsigned int feedDots),
+            addTime(unsigned long t),
+            statusByte(uint8_t c),
+            expireStatus(),
+            setStatus(uint8_t mask, uint8_t flags),
+            drain(size_t len=(size_t)-1),
+            dequeue(size_t len);
         void
+            rasterRows(const uint8_t *rows, int n, int rowBytes, bool trim,
+                    int &feed, int &margin),
+            skipDots(int dots),
+            emit(uint8_t c),
+            emit(const uint8_t *buf, size_t len),
+            emit_P(const uint8_t *buf, size_t len),
+            send(const uint8_t *buf, size_t len),
+            send(const uint8_t *a, size_t aLen, const uint8_t *b, size_t bLen),
+            endLine(),
             writeBytes(uint8_t a),
             writeBytes(uint8_t a, uint8_t b),
             writeBytes(uint8_t a, uint8_t b, uint8_t c),
             writeBytes(uint8_t a, uint8_t b, uint8_t c, uint8_t d),
+            resetLayout(),
+            trackCommands(const uint8_t *cmds, size_t len, bool fromProgMem),
             setPrintMode(uint8_t mask),
             unsetPrintMode(uint8_t mask),
             writePrintMode();
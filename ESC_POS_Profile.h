@@ -0,0 +1,52 @@
+/*------------------------------------------------------------------------
+  Printer profiles for ESC_POS_Printer.
+
+  A profile gives the paper width and the optional commands a printer
+  understands.  Pass one to the printer's constructor, e.g.
+  ESC_POS_Printer printer(&stream, ESC_POS_80mm), so one sketch can
+  drive 58 mm and 80 mm printers side by side.  Printers made without
+  one get ESC_POS_PROFILE, ESC_POS_58mm unless it is defined in the
+  build flags.  A sketch with only one kind of printer can also define
+  ESC_POS_PROFILE_FIXED=1: every printer then has ESC_POS_PROFILE, known
+  at compile time, so paper geometry is folded into constants and the
+  code for commands the profile lacks is left out.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_PROFILE_H
+#define ESC_POS_PROFILE_H
+
+#include <stdint.h>
+
+struct ESC_POS_Profile {
+    uint16_t dots;           // Printable width in dots
+    uint8_t  columns;        // Characters per line in font A
+    bool     rasterGraphics, // GS v 0
+             qrCode,         // GS ( k
+             graphicsMemory, // GS ( L download graphics
+             statusBack,     // GS a
+             cutter;         // GS V
+};
+
+// 58 mm paper, 384 dots.  The printers this library was written for.
+static constexpr ESC_POS_Profile ESC_POS_58mm = {
+    384, 32, true, true, true, true, false
+};
+
+// 80 mm paper, 576 dots, with a cutter
+static constexpr ESC_POS_Profile ESC_POS_80mm = {
+    576, 48, true, true, true, true, true
+};
+
+// 58 mm printers with only the older commands: graphics use ESC *, QR
+// codes are drawn by the library, one image at a time can be stored
+// with GS * and status must be asked for.
+static constexpr ESC_POS_Profile ESC_POS_58mmBasic = {
+    384, 32, false, false, false, false, false
+};
+
+#ifndef ESC_POS_PROFILE
+#define ESC_POS_PROFILE ESC_POS_58mm
+#endif
+
+#endif // ESC_POS_PROFILE_H
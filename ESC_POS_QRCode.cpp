@@ -0,0 +1,459 @@
+/*------------------------------------------------------------------------
+  QR code encoder for ESC_POS_Printer.
+
+  Based on Project Nayuki's QR Code generator library (MIT license),
+  https://www.nayuki.io/page/qr-code-generator-library
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_QRCode.h"
+
+#define MAX_CODEWORDS  ((ESC_POS_QR_MAX_SIZE * ESC_POS_QR_MAX_SIZE) / 8)
+#define MATRIX_BYTES   ((ESC_POS_QR_MAX_SIZE * ESC_POS_QR_MAX_SIZE + 7) / 8)
+
+// Error correction codewords per block, by level (L, M, Q, H) and version
+static const uint8_t eccPerBlock[4][41] PROGMEM = {
+    { 0,  7, 10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28,
+         28, 28, 30, 30, 26, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30 },
+    { 0, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26, 30, 22, 22, 24, 24, 28, 28, 26, 26, 26,
+         26, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28 },
+    { 0, 13, 22, 18, 26, 18, 24, 18, 22, 20, 24, 28, 26, 24, 20, 30, 24, 28, 28, 26, 30,
+         28, 30, 30, 30, 30, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30 },
+    { 0, 17, 28, 22, 16, 22, 28, 26, 26, 24, 28, 24, 28, 22, 24, 24, 30, 28, 28, 26, 28,
+         30, 24, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30 },
+};
+
+// Error correction blocks, by level (L, M, Q, H) and version
+static const uint8_t eccBlocks[4][41] PROGMEM = {
+    { 0, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4,  4,  4,  4,  4,  6,  6,  6,  6,  7,  8,
+          8,  9,  9, 10, 12, 12, 12, 13, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 24, 25 },
+    { 0, 1, 1, 1, 2, 2, 4, 4, 4, 5, 5,  5,  8,  9,  9, 10, 10, 11, 13, 14, 16,
+         17, 17, 18, 20, 21, 23, 25, 26, 28, 29, 31, 33, 35, 37, 38, 40, 43, 45, 47, 49 },
+    { 0, 1, 1, 2, 2, 4, 4, 6, 6, 8, 8,  8, 10, 12, 16, 12, 17, 16, 18, 21, 20,
+         23, 23, 25, 27, 29, 34, 34, 35, 38, 40, 43, 45, 48, 51, 53, 56, 59, 62, 65, 68 },
+    { 0, 1, 1, 2, 4, 4, 4, 5, 6, 8, 8, 11, 11, 16, 16, 18, 16, 19, 21, 25, 25,
+         25, 34, 30, 32, 35, 37, 40, 42, 45, 48, 51, 54, 57, 60, 63, 66, 70, 74, 77, 81 },
+};
+
+// === Bit matrix helpers ===
+
+static bool getModule(const uint8_t *m, int size, int x, int y) {
+    int i = y * size + x;
+    return (m[i >> 3] >> (i & 7)) & 1;
+}
+
+static void setModule(uint8_t *m, int size, int x, int y, bool dark) {
+    int i = y * size + x;
+    if(dark) m[i >> 3] |=  (1 << (i & 7));
+    else     m[i >> 3] &= ~(1 << (i & 7));
+}
+
+static void fillRect(uint8_t *m, int size, int left, int top, int w, int h) {
+    for(int dy = 0; dy < h; dy++) {
+        for(int dx = 0; dx < w; dx++) setModule(m, size, left + dx, top + dy, true);
+    }
+}
+
+// === Version geometry ===
+
+// Modules left for data and error correction after the function patterns
+static int rawDataModules(int ver) {
+    int result = (16 * ver + 128) * ver + 64;
+    if(ver >= 2) {
+        int numAlign = ver / 7 + 2;
+        result -= (25 * numAlign - 10) * numAlign - 55;
+        if(ver >= 7) result -= 36;
+    }
+    return result;
+}
+
+static int dataCodewords(int ver, int ecl) {
+    return rawDataModules(ver) / 8 -
+        pgm_read_byte(&eccPerBlock[ecl][ver]) * pgm_read_byte(&eccBlocks[ecl][ver]);
+}
+
+// Centre positions of the alignment patterns; returns how many there are
+static int alignmentPositions(int ver, uint8_t pos[7]) {
+    if(ver == 1) return 0;
+    int numAlign = ver / 7 + 2;
+    int step = (ver * 8 + numAlign * 3 + 5) / (numAlign * 4 - 4) * 2;
+    for(int i = numAlign - 1, p = ver * 4 + 10; i >= 1; i--, p -= step) {
+        pos[i] = p;
+    }
+    pos[0] = 6;
+    return numAlign;
+}
+
+// === Reed-Solomon ===
+
+static uint8_t gfMultiply(uint8_t x, uint8_t y) {
+    uint8_t z = 0;
+    for(int i = 7; i >= 0; i--) {
+        z = (z << 1) ^ ((z >> 7) * 0x1D);
+        z ^= ((y >> i) & 1) * x;
+    }
+    return z;
+}
+
+static void rsDivisor(int degree, uint8_t *result) {
+    uint8_t root = 1;
+    memset(result, 0, degree);
+    result[degree - 1] = 1;
+    for(int i = 0; i < degree; i++) {
+        for(int j = 0; j < degree; j++) {
+            result[j] = gfMultiply(result[j], root);
+            if(j + 1 < degree) result[j] ^= result[j + 1];
+        }
+        root = gfMultiply(root, 0x02);
+    }
+}
+
+static void rsRemainder(const uint8_t *data, int len,
+        const uint8_t *divisor, int degree, uint8_t *result) {
+    memset(result, 0, degree);
+    for(int i = 0; i < len; i++) {
+        uint8_t factor = data[i] ^ result[0];
+        memmove(result, result + 1, degree - 1);
+        result[degree - 1] = 0;
+        for(int j = 0; j < degree; j++) result[j] ^= gfMultiply(divisor[j], factor);
+    }
+}
+
+// Split data into blocks, add error correction to each and interleave
+static void addEcc(const uint8_t *data, int ver, int ecl, uint8_t *result) {
+    int numBlocks    = pgm_read_byte(&eccBlocks[ecl][ver]);
+    int blockEccLen  = pgm_read_byte(&eccPerBlock[ecl][ver]);
+    int rawCodewords = rawDataModules(ver) / 8;
+    int dataLen      = dataCodewords(ver, ecl);
+    int numShort     = numBlocks - rawCodewords % numBlocks;
+    int shortLen     = rawCodewords / numBlocks - blockEccLen;
+    uint8_t divisor[30], ecc[30];
+
+    rsDivisor(blockEccLen, divisor);
+    for(int i = 0; i < numBlocks; i++) {
+        int len = shortLen + (i < numShort ? 0 : 1);
+        rsRemainder(data, len, divisor, blockEccLen, ecc);
+        for(int j = 0, k = i; j < len; j++, k += numBlocks) {
+            if(j == shortLen) k -= numShort;
+            result[k] = data[j];
+        }
+        for(int j = 0, k = dataLen + i; j < blockEccLen; j++, k += numBlocks) {
+            result[k] = ecc[j];
+        }
+        data += len;
+    }
+}
+
+// === Drawing ===
+
+// Mark every function module dark
+static void functionModules(uint8_t *m, int ver, int size) {
+    uint8_t pos[7];
+    int n = alignmentPositions(ver, pos);
+
+    memset(m, 0, (size * size + 7) / 8);
+    fillRect(m, size, 6, 0, 1, size);        // Timing patterns
+    fillRect(m, size, 0, 6, size, 1);
+    fillRect(m, size, 0, 0, 9, 9);           // Finders and format bits
+    fillRect(m, size, size - 8, 0, 8, 9);
+    fillRect(m, size, 0, size - 8, 9, 8);
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < n; j++) {
+            if((i == 0 && j == 0) || (i == 0 && j == n - 1) || (i == n - 1 && j == 0))
+                continue;                    // Finder corners
+            fillRect(m, size, pos[i] - 2, pos[j] - 2, 5, 5);
+        }
+    }
+    if(ver >= 7) {                           // Version information
+        fillRect(m, size, size - 11, 0, 3, 6);
+        fillRect(m, size, 0, size - 11, 6, 3);
+    }
+}
+
+// Clear the light parts of the function patterns and draw the version
+static void lightFunctionModules(uint8_t *m, int ver, int size) {
+    uint8_t pos[7];
+    int n = alignmentPositions(ver, pos);
+
+    for(int i = 7; i < size - 7; i += 2) {
+        setModule(m, size, 6, i, false);
+        setModule(m, size, i, 6, false);
+    }
+    for(int dy = -4; dy <= 4; dy++) {
+        for(int dx = -4; dx <= 4; dx++) {
+            int dist = max(abs(dx), abs(dy));
+            if(dist != 2 && dist != 4) continue;
+            if(3 + dx >= 0 && 3 + dy >= 0)
+                setModule(m, size, 3 + dx, 3 + dy, false);
+            if(size - 4 + dx < size && 3 + dy >= 0)
+                setModule(m, size, size - 4 + dx, 3 + dy, false);
+            if(3 + dx >= 0 && size - 4 + dy < size)
+                setModule(m, size, 3 + dx, size - 4 + dy, false);
+        }
+    }
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < n; j++) {
+            if((i == 0 && j == 0) || (i == 0 && j == n - 1) || (i == n - 1 && j == 0))
+                continue;
+            for(int dy = -1; dy <= 1; dy++) {
+                for(int dx = -1; dx <= 1; dx++) {
+                    setModule(m, size, pos[i] + dx, pos[j] + dy, dx == 0 && dy == 0);
+                }
+            }
+        }
+    }
+    if(ver >= 7) {
+        long rem = ver;
+        for(int i = 0; i < 12; i++) rem = (rem << 1) ^ ((rem >> 11) * 0x1F25);
+        long bits = (long)ver << 12 | rem;
+        for(int i = 0; i < 6; i++) {
+            for(int j = 0; j < 3; j++) {
+                int k = size - 11 + j;
+                setModule(m, size, k, i, bits & 1);
+                setModule(m, size, i, k, bits & 1);
+                bits >>= 1;
+            }
+        }
+    }
+}
+
+// Place the codewords in the zigzag order, skipping function modules
+// (which are dark in m at this point)
+static void drawCodewords(const uint8_t *data, int len, uint8_t *m, int size) {
+    int i = 0;
+    for(int right = size - 1; right >= 1; right -= 2) {
+        if(right == 6) right = 5;
+        for(int vert = 0; vert < size; vert++) {
+            for(int j = 0; j < 2; j++) {
+                int x = right - j;
+                bool upward = ((right + 1) & 2) == 0;
+                int y = upward ? size - 1 - vert : vert;
+                if(!getModule(m, size, x, y) && i < len * 8) {
+                    setModule(m, size, x, y, (data[i >> 3] >> (7 - (i & 7))) & 1);
+                    i++;
+                }
+            }
+        }
+    }
+}
+
+// XOR a mask pattern over the non-function modules; applying it twice
+// undoes it
+static void applyMask(const uint8_t *func, uint8_t *m, int size, int mask) {
+    for(int y = 0; y < size; y++) {
+        for(int x = 0; x < size; x++) {
+            if(getModule(func, size, x, y)) continue;
+            bool invert;
+            switch(mask) {
+                case 0:  invert = (x + y) % 2 == 0;                     break;
+                case 1:  invert = y % 2 == 0;                           break;
+                case 2:  invert = x % 3 == 0;                           break;
+                case 3:  invert = (x + y) % 3 == 0;                     break;
+                case 4:  invert = (x / 3 + y / 2) % 2 == 0;             break;
+                case 5:  invert = x * y % 2 + x * y % 3 == 0;           break;
+                case 6:  invert = (x * y % 2 + x * y % 3) % 2 == 0;     break;
+                default: invert = ((x + y) % 2 + x * y % 3) % 2 == 0;  break;
+            }
+            if(invert) setModule(m, size, x, y, !getModule(m, size, x, y));
+        }
+    }
+}
+
+static void drawFormatBits(int ecl, int mask, uint8_t *m, int size) {
+    static const uint8_t levelBits[4] = { 1, 0, 3, 2 }; // L M Q H
+    int data = levelBits[ecl] << 3 | mask;
+    int rem = data;
+    for(int i = 0; i < 10; i++) rem = (rem << 1) ^ ((rem >> 9) * 0x537);
+    int bits = (data << 10 | rem) ^ 0x5412;
+
+    for(int i = 0; i <= 5; i++) setModule(m, size, 8, i, (bits >> i) & 1);
+    setModule(m, size, 8, 7, (bits >> 6) & 1);
+    setModule(m, size, 8, 8, (bits >> 7) & 1);
+    setModule(m, size, 7, 8, (bits >> 8) & 1);
+    for(int i = 9; i < 15; i++) setModule(m, size, 14 - i, 8, (bits >> i) & 1);
+
+    for(int i = 0; i < 8; i++) setModule(m, size, size - 1 - i, 8, (bits >> i) & 1);
+    for(int i = 8; i < 15; i++) setModule(m, size, 8, size - 15 + i, (bits >> i) & 1);
+    setModule(m, size, 8, size - 8, true); // Always dark
+}
+
+// === Mask penalty ===
+
+static void addRun(int length, int history[7], int size) {
+    if(history[0] == 0) length += size; // Light border before the first run
+    memmove(&history[1], &history[0], 6 * sizeof(history[0]));
+    history[0] = length;
+}
+
+// Count finder-like 1:1:3:1:1 patterns with light space on either side
+static int finderPatterns(const int history[7]) {
+    int n = history[1];
+    bool core = n > 0 && history[2] == n && history[3] == n * 3 &&
+        history[4] == n && history[5] == n;
+    return (core && history[0] >= n * 4 && history[6] >= n ? 1 : 0) +
+           (core && history[6] >= n * 4 && history[0] >= n ? 1 : 0);
+}
+
+static int finishRuns(bool dark, int length, int history[7], int size) {
+    if(dark) {
+        addRun(length, history, size);
+        length = 0;
+    }
+    addRun(length + size, history, size); // Light border after the last run
+    return finderPatterns(history);
+}
+
+static long penalty(const uint8_t *m, int size) {
+    long result = 0;
+    int history[7];
+
+    // Runs of one colour and finder-like patterns, along rows (pass 0)
+    // and columns (pass 1)
+    for(int pass = 0; pass < 2; pass++) {
+        for(int a = 0; a < size; a++) {
+            bool runColor = false;
+            int run = 0;
+            memset(history, 0, sizeof(history));
+            for(int b = 0; b < size; b++) {
+                bool dark = pass ? getModule(m, size, a, b) : getModule(m, size, b, a);
+                if(dark == runColor) {
+                    run++;
+                    if(run == 5)     result += 3;
+                    else if(run > 5) result++;
+                } else {
+                    addRun(run, history, size);
+                    if(!runColor) result += finderPatterns(history) * 40;
+                    runColor = dark;
+                    run = 1;
+                }
+            }
+            result += finishRuns(runColor, run, history, size) * 40;
+        }
+    }
+
+    // 2x2 blocks of one colour
+    for(int y = 0; y < size - 1; y++) {
+        for(int x = 0; x < size - 1; x++) {
+            bool c = getModule(m, size, x, y);
+            if(c == getModule(m, size, x + 1, y) &&
+               c == getModule(m, size, x, y + 1) &&
+               c == getModule(m, size, x + 1, y + 1)) result += 3;
+        }
+    }
+
+    // Balance of dark and light
+    long dark = 0, total = (long)size * size;
+    for(int y = 0; y < size; y++) {
+        for(int x = 0; x < size; x++) dark += getModule(m, size, x, y);
+    }
+    int k = (int)((labs(dark * 20 - total * 10) + total - 1) / total) - 1;
+    result += k * 10;
+
+    return result;
+}
+
+// === ESC_POS_QRCode ===
+
+ESC_POS_QRCode::ESC_POS_QRCode() :
+    version(0), qrsize(0), scale(1), nextRow(0) {
+    }
+
+bool ESC_POS_QRCode::encode(
+        const uint8_t *data, size_t len, char ecLevel, int8_t mask) {
+    uint8_t dataBits[MAX_CODEWORDS], codewords[MAX_CODEWORDS], func[MATRIX_BYTES];
+    int ecl, ver, capacity = 0, bits = 0;
+
+    switch(toupper(ecLevel)) {
+        case 'L': ecl = 0; break;
+        default:  ecl = 1; break;
+        case 'Q': ecl = 2; break;
+        case 'H': ecl = 3; break;
+    }
+
+    // Smallest version that holds mode, count and data in byte mode
+    for(ver = 1; ver <= ESC_POS_QR_MAX_VERSION; ver++) {
+        capacity = dataCodewords(ver, ecl) * 8;
+        bits = 4 + (ver <= 9 ? 8 : 16) + 8 * (long)len;
+        if(bits <= capacity) break;
+    }
+    version = qrsize = 0;
+    if(ver > ESC_POS_QR_MAX_VERSION) return false;
+
+    // Data bits: mode, count, bytes, terminator, then pad codewords
+    int n = 0;
+    memset(dataBits, 0, capacity / 8);
+    uint32_t header = (0x4UL << (ver <= 9 ? 8 : 16)) | len;
+    int headerBits = 4 + (ver <= 9 ? 8 : 16);
+    for(int i = headerBits - 1; i >= 0; i--, n++) {
+        if((header >> i) & 1) dataBits[n >> 3] |= 0x80 >> (n & 7);
+    }
+    for(size_t i = 0; i < len; i++, n += 8) {
+        dataBits[n >> 3] |= data[i] >> (n & 7);
+        if(n & 7) dataBits[(n >> 3) + 1] |= data[i] << (8 - (n & 7));
+    }
+    n += min(4, capacity - n);               // Terminator
+    n = (n + 7) / 8;                         // Whole bytes
+    for(uint8_t pad = 0xEC; n < capacity / 8; n++, pad ^= 0xEC ^ 0x11) {
+        dataBits[n] = pad;
+    }
+
+    int size = ver * 4 + 17;
+    addEcc(dataBits, ver, ecl, codewords);
+
+    functionModules(modules, ver, size);
+    drawCodewords(codewords, rawDataModules(ver) / 8, modules, size);
+    lightFunctionModules(modules, ver, size);
+    functionModules(func, ver, size);
+
+    if(mask < 0 || mask > 7) {
+        long best = 0;
+        mask = -1;
+        for(int i = 0; i < 8; i++) {
+            applyMask(func, modules, size, i);
+            drawFormatBits(ecl, i, modules, size);
+            long p = penalty(modules, size);
+            if(mask < 0 || p < best) {
+                mask = i;
+                best = p;
+            }
+            applyMask(func, modules, size, i);
+        }
+    }
+    applyMask(func, modules, size, mask);
+    drawFormatBits(ecl, mask, modules, size);
+
+    version = ver;
+    qrsize  = size;
+    return true;
+}
+
+uint8_t ESC_POS_QRCode::size() {
+    return qrsize;
+}
+
+bool ESC_POS_QRCode::module(int x, int y) {
+    if(x < 0 || y < 0 || x >= qrsize || y >= qrsize) return false;
+    return getModule(modules, qrsize, x, y);
+}
+
+int ESC_POS_QRCode::render(uint8_t moduleSize) {
+    scale   = moduleSize ? moduleSize : 1;
+    nextRow = 0;
+    return (qrsize + 2 * ESC_POS_QR_QUIET_ZONE) * scale;
+}
+
+bool ESC_POS_QRCode::readRow(uint8_t *row, int nBytes) {
+    int y = nextRow++ / scale - ESC_POS_QR_QUIET_ZONE;
+    int dots = min(nBytes * 8, (qrsize + 2 * ESC_POS_QR_QUIET_ZONE) * scale);
+
+    memset(row, 0, nBytes);
+    if(y < 0 || y >= qrsize) return true;
+    for(int x = 0; x < qrsize; x++) {
+        if(!getModule(modules, qrsize, x, y)) continue;
+        int d = (x + ESC_POS_QR_QUIET_ZONE) * scale;
+        for(int i = 0; i < scale && d < dots; i++, d++) {
+            row[d >> 3] |= 0x80 >> (d & 7);
+        }
+    }
+    return true;
+}
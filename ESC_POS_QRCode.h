@@ -0,0 +1,67 @@
+/*------------------------------------------------------------------------
+  QR code encoder for ESC_POS_Printer.
+
+  Used when the printer cannot draw QR codes itself (GS ( k).  Data is
+  encoded in byte mode, the symbol is built in a bit matrix and handed to
+  printImage() one row of dots at a time.  Based on Project Nayuki's
+  QR Code generator (MIT license).
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_QRCODE_H
+#define ESC_POS_QRCODE_H
+
+#include "Arduino.h"
+#include "ESC_POS_Image.h"
+
+// Largest QR code version (1 to 40) the encoder will make.  Version 10 is
+// 57 x 57 modules and holds 213 bytes at error correction level M.  The
+// symbol takes (17 + 4 * version)^2 / 8 bytes, and encoding needs about
+// three times that on the stack.
+#ifndef ESC_POS_QR_MAX_VERSION
+#define ESC_POS_QR_MAX_VERSION 10
+#endif
+
+#define ESC_POS_QR_MAX_SIZE    (17 + 4 * ESC_POS_QR_MAX_VERSION)
+#define ESC_POS_QR_QUIET_ZONE  4 // White modules around the symbol
+
+class ESC_POS_QRCode : public ESC_POS_RowSource {
+
+    public:
+
+        ESC_POS_QRCode();
+
+        // Encode len bytes of data at error correction level 'L', 'M',
+        // 'Q' or 'H', in the smallest version that fits.  mask 0 to 7
+        // forces a mask pattern, -1 picks the best one.  Returns false if
+        // the data does not fit in ESC_POS_QR_MAX_VERSION.
+        bool
+            encode(const uint8_t *data, size_t len, char ecLevel='M',
+                    int8_t mask=-1);
+        // Modules per side, 0 if nothing is encoded
+        uint8_t
+            size();
+        // True for a dark module, x is the column and y the row
+        bool
+            module(int x, int y);
+
+        // Draw each module as a square of moduleSize dots, with the quiet
+        // zone, and start again at the top row.  Returns the width (and
+        // height) of the image in dots.
+        int
+            render(uint8_t moduleSize);
+        bool
+            readRow(uint8_t *row, int nBytes);
+
+    private:
+
+        uint8_t
+            version,
+            qrsize,
+            scale,
+            modules[(ESC_POS_QR_MAX_SIZE * ESC_POS_QR_MAX_SIZE + 7) / 8];
+        int
+            nextRow;
+};
+
+#endif // ESC_POS_QRCODE_H
@@ -0,0 +1,84 @@
+/*------------------------------------------------------------------------
+  Recorded receipts for ESC_POS_Printer.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Receipt.h"
+#include "ESC_POS_Commands.h"
+
+// Header line of a copy, and back to the modes after ESC @.  The
+// recording then sets the modes it was made with.
+typedef ESC_POS_Cat<ESC_POS_Justify<'C'>, ESC_POS_Size<2, 2>,
+    ESC_POS_BoldOn>::type HeaderOn;
+typedef ESC_POS_Cat<ESC_POS_BoldOff, ESC_POS_Size<1, 1>,
+    ESC_POS_Justify<'L'> >::type HeaderOff;
+
+ESC_POS_Receipt::ESC_POS_Receipt(uint8_t *buffer, size_t size, Print *spill) :
+    printer(NULL), buffer(buffer), spill(spill), size(size) {
+    clear();
+}
+
+void ESC_POS_Receipt::clear() {
+    len     = 0;
+    spilled = 0;
+    work    = 0;
+    lost    = false;
+}
+
+void ESC_POS_Receipt::record(ESC_POS_Printer &printer, bool print) {
+    if(this->printer) stop();
+    clear();
+    this->printer = &printer;
+    printer.startCapture(this, print);
+}
+
+bool ESC_POS_Receipt::stop() {
+    if(printer) {
+        work    = printer->endCapture();
+        printer = NULL;
+    }
+    return !lost;
+}
+
+size_t ESC_POS_Receipt::length() {
+    return len + spilled;
+}
+
+const uint8_t *ESC_POS_Receipt::data() {
+    return (lost || spilled) ? NULL : buffer;
+}
+
+unsigned long ESC_POS_Receipt::printTime() {
+    return work;
+}
+
+bool ESC_POS_Receipt::replay(ESC_POS_Printer &printer, const char *header,
+        Stream *spilled) {
+    stop();
+    if(lost || (this->spilled && !spilled)) return false;
+    if(header) {
+        printer.command<HeaderOn>();
+        printer.println(header);
+        printer.command<HeaderOff>();
+    }
+    printer.replay(buffer, len, work);
+    if(this->spilled) return printer.replay(spilled, this->spilled);
+    return true;
+}
+
+size_t ESC_POS_Receipt::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t ESC_POS_Receipt::write(const uint8_t *data, size_t n) {
+    size_t room = min(n, size - len);
+
+    memcpy(buffer + len, data, room);
+    len += room;
+    if(room < n) {
+        size_t rest = spill ? spill->write(data + room, n - room) : 0;
+        spilled += rest;
+        if(rest < n - room) lost = true;
+    }
+    return n;
+}
@@ -0,0 +1,74 @@
+/*------------------------------------------------------------------------
+  Recorded receipts for ESC_POS_Printer.
+
+  A receipt printed more than once -- customer and merchant copies, or a
+  reprint on demand -- need only be laid out once.  ESC_POS_Receipt
+  records the bytes the printer sends for a job, into a buffer and then,
+  once that is full, an optional spill stream such as an SD file.  Each
+  copy sends the recording again as it is: text layout, dithering and
+  barcode encoding are not repeated.  Images printed from printer memory
+  (ESC_POS_ImageCache) are recorded as the command that prints them, so
+  they must still be there when the copy is printed.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_RECEIPT_H
+#define ESC_POS_RECEIPT_H
+
+#include "ESC_POS_Printer.h"
+
+class ESC_POS_Receipt : public Print {
+
+    public:
+
+        // The first size bytes of the recording go in buffer, the rest to
+        // spill if given (e.g. a file open for writing) or are lost.
+        ESC_POS_Receipt(uint8_t *buffer, size_t size, Print *spill=NULL);
+
+        // Record what printer sends until stop().  With print false the
+        // job is only recorded, to be printed by replay().
+        void
+            record(ESC_POS_Printer &printer, bool print=true),
+            clear();
+        // stop() returns false if the recording did not fit.  replay()
+        // prints it again, after header (e.g. "COPY") centred in large
+        // bold type if given.  Bytes that went to the spill are read back
+        // from spilled, the same file open for reading.  Returns false if
+        // the recording is incomplete or spilled runs short.
+        bool
+            stop(),
+            replay(ESC_POS_Printer &printer, const char *header=NULL,
+                    Stream *spilled=NULL);
+        size_t
+            length();      // Bytes recorded
+        // The recording, or NULL if it is not all in the buffer, and its
+        // printing time for replay()
+        const uint8_t
+            *data();
+        unsigned long
+            printTime();
+
+        size_t
+            write(uint8_t c),
+            write(const uint8_t *data, size_t len);
+        using Print::write;
+
+    private:
+
+        ESC_POS_Printer
+            *printer;      // Printer being recorded, NULL when stopped
+        uint8_t
+            *buffer;
+        Print
+            *spill;
+        size_t
+            size,
+            len,           // Bytes in buffer
+            spilled;       // Bytes written to spill
+        unsigned long
+            work;          // Printing time, from endCapture()
+        bool
+            lost;          // Bytes that did not fit were dropped
+};
+
+#endif // ESC_POS_RECEIPT_H
@@ -0,0 +1,65 @@
+/*------------------------------------------------------------------------
+  Output statistics for ESC_POS_Printer.
+
+  Built with ESC_POS_STATS defined as 1, the printer counts the bytes and
+  commands it sends by kind and the dot rows it prints and feeds, for the
+  printer's life and for the current job.  From these come estimates of
+  transfer time, print time and paper used.  Left at 0 (the default) no
+  counting code or storage is built.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_STATS_H
+#define ESC_POS_STATS_H
+
+#include "Arduino.h"
+
+#ifndef ESC_POS_STATS
+#define ESC_POS_STATS 0
+#endif
+
+// What output was for
+enum {
+    STAT_TEXT,    // Printed characters, line ends and tabs
+    STAT_STYLE,   // Mode commands: bold, size, justification ...
+    STAT_IMAGE,   // Bitmaps, images and QR codes
+    STAT_BARCODE,
+    STAT_FEED,    // Paper feeds and cuts
+    STAT_OTHER,   // Reset, status, tab stops ...
+    STAT_KINDS
+};
+
+struct ESC_POS_Stats {
+    uint32_t
+        bytes[STAT_KINDS],
+        commands[STAT_KINDS],
+        printRows,    // Dot rows printed (text lines, images, barcodes)
+        feedRows;     // Dot rows fed without printing
+
+    uint32_t totalBytes() const {
+        uint32_t n = 0;
+        for(uint8_t i = 0; i < STAT_KINDS; i++) n += bytes[i];
+        return n;
+    }
+
+    // Milliseconds to send the bytes at baud, 11 bits a byte as in
+    // setPacing()
+    uint32_t transferMillis(unsigned long baud) const {
+        return baud ? (uint32_t)(totalBytes() * 11000.0 / baud) : 0;
+    }
+
+    // Milliseconds to print and feed, given microseconds per dot row as
+    // in setTimes()
+    uint32_t printMillis(unsigned long dotPrintTime,
+            unsigned long dotFeedTime) const {
+        return (uint32_t)((printRows * (double)dotPrintTime +
+                           feedRows  * (double)dotFeedTime) / 1000);
+    }
+
+    // Paper used in millimetres, 8 dots to the millimetre at 203 dpi
+    uint32_t paperMillimetres(uint8_t dotsPerMM=8) const {
+        return (printRows + feedRows) / dotsPerMM;
+    }
+};
+
+#endif // ESC_POS_STATS_H
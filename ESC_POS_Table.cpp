@@ -0,0 +1,105 @@
+/*------------------------------------------------------------------------
+  Column layout for ESC_POS_Printer.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Table.h"
+
+ESC_POS_Table::ESC_POS_Table(
+        const ESC_POS_Column *columns, uint8_t count, uint8_t gap) :
+    columns(columns), count(min(count, (uint8_t)ESC_POS_TABLE_MAX_COLUMNS)) {
+    uint8_t x = 0;
+    for(uint8_t i = 0; i < this->count; i++) {
+        start[i] = x;
+        x += columns[i].width + gap;
+    }
+}
+
+uint8_t ESC_POS_Table::width() {
+    if(!count) return 0;
+    return start[count - 1] + columns[count - 1].width;
+}
+
+// True for the second and later bytes of a UTF-8 sequence, which take
+// no column of their own
+static inline bool continues(const char *text, bool utf8) {
+    return utf8 && ((*text & 0xC0) == 0x80);
+}
+
+// Length in bytes of the part of text that goes on this line of a column,
+// in *chars how many characters that is, and in *rest where the next line
+// starts.  Wrapped text breaks after the last space that fits, or mid word
+// if there is none, but never inside a UTF-8 sequence; '\n' always breaks.
+static size_t lineOf(const char *text, uint8_t width, bool wrap, bool utf8,
+        const char **rest, uint8_t *chars) {
+    size_t n = 0;
+    uint8_t used = 0;
+
+    while(text[n] && (text[n] != '\n')) {
+        if(!continues(text + n, utf8)) {
+            if(used == width) break;
+            used++;
+        }
+        n++;
+    }
+    size_t len = n;
+    if(!wrap) {
+        *rest = text + n + strlen(text + n);
+    } else if(text[n] == '\n') {
+        *rest = text + n + 1;
+    } else {
+        if(text[n] && (text[n] != ' ')) {
+            // Mid word: go back to the last space, if any
+            size_t cut = n;
+            while((cut > 0) && (text[cut - 1] != ' ')) cut--;
+            if(cut > 0) n = len = cut;
+        }
+        while((len > 0) && (text[len - 1] == ' ')) len--;
+        while(text[n] == ' ') n++;
+        *rest = text + n;
+    }
+    *chars = 0;
+    for(size_t i = 0; i < len; i++) {
+        if(!continues(text + i, utf8)) (*chars)++;
+    }
+    return len;
+}
+
+void ESC_POS_Table::printRow(
+        ESC_POS_Printer &printer, const char *const cells[]) {
+    // One character in font A, in ESC $ units (dots)
+    const ESC_POS_Profile &profile = printer.profile();
+    const uint16_t charDots = profile.dots / profile.columns;
+    const char *next[ESC_POS_TABLE_MAX_COLUMNS];
+    char justified = printer.justification();
+    // Encoded text is UTF-8, one column for each character
+    bool utf8 = printer.textEncoder() != NULL;
+    bool more = true;
+
+    for(uint8_t i = 0; i < count; i++) next[i] = cells[i] ? cells[i] : "";
+    printer.justify('L'); // ESC $ counts from the left margin
+
+    // First line, then more while wrapped cells have text left
+    for(bool first = true; first || more; first = false) {
+        uint8_t x = 0;   // Where the printer is, in characters
+        more = false;
+        for(uint8_t i = 0; i < count; i++) {
+            const ESC_POS_Column &col = columns[i];
+            const char *text = next[i];
+            if(!col.width) continue; // Would never use up its text
+            uint8_t chars;
+            size_t len = lineOf(text, col.width, col.wrap, utf8, &next[i], &chars);
+            if(*next[i]) more = true;
+            if(!len) continue;
+
+            uint8_t at = start[i];
+            if(col.align == 'R' || col.align == 'r') at += col.width - chars;
+            else if(col.align == 'C' || col.align == 'c') at += (col.width - chars) / 2;
+            if(at != x) printer.setPosition(at * charDots);
+            printer.write((const uint8_t *)text, len);
+            x = at + chars;
+        }
+        printer.write('\n');
+    }
+    if(justified) printer.justify(justified);
+}
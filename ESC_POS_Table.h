@@ -0,0 +1,54 @@
+/*------------------------------------------------------------------------
+  Column layout for ESC_POS_Printer.
+
+  A table prints rows of cells (item / qty / price ...) in fixed columns.
+  Each cell is aligned left, centred or right and either cut to its
+  column or word wrapped onto more lines.  Cells are placed with ESC $
+  absolute positions instead of being padded with spaces.  Each row is
+  laid out in one pass, a line at a time, without copying the cells.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_TABLE_H
+#define ESC_POS_TABLE_H
+
+#include "ESC_POS_Printer.h"
+
+#ifndef ESC_POS_TABLE_MAX_COLUMNS
+#define ESC_POS_TABLE_MAX_COLUMNS 8
+#endif
+
+struct ESC_POS_Column {
+    uint8_t width; // Characters, 0 to leave the column out
+    char    align; // 'L', 'C' or 'R', as justify()
+    bool    wrap;  // Word wrap onto more lines, else cut at width
+};
+
+class ESC_POS_Table {
+
+    public:
+
+        // Columns are laid out left to right with gap characters between
+        // them.  The array must stay in memory as long as the table.
+        ESC_POS_Table(const ESC_POS_Column *columns, uint8_t count, uint8_t gap=1);
+
+        // Print one row, cells[i] going in column i.  NULL cells are
+        // left blank.  Text is printed in normal width.  With an encoder
+        // set (setEncoder()) cells are UTF-8 and measured in characters,
+        // else in bytes.  The row is left justified; justification is put
+        // back afterwards.
+        void
+            printRow(ESC_POS_Printer &printer, const char *const cells[]);
+        uint8_t
+            width();       // Characters from the first column to the last
+
+    private:
+
+        const ESC_POS_Column
+            *columns;
+        uint8_t
+            count,
+            start[ESC_POS_TABLE_MAX_COLUMNS]; // First character of each column
+};
+
+#endif // ESC_POS_TABLE_H
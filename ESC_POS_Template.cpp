@@ -0,0 +1,190 @@
+/*------------------------------------------------------------------------
+  Receipt templates for ESC_POS_Printer.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Template.h"
+
+// Program instructions, each an op byte followed by its operands
+#define OP_END    0 // End of program
+#define OP_TEXT   1 // len, len bytes of text
+#define OP_FIELD  2 // field number, width, alignment ('<', '>' or '^')
+#define OP_STYLE  3 // style letter from the layout
+
+ESC_POS_Template::ESC_POS_Template(uint8_t *buffer, size_t size) :
+    program(buffer), fields(0), capacity(size), length(0), compiled(false) {
+    }
+
+bool ESC_POS_Template::compile(const char *layout) {
+    return compile(layout, false);
+}
+
+bool ESC_POS_Template::compile(const __FlashStringHelper *layout) {
+    return compile(reinterpret_cast<const char *>(layout), true);
+}
+
+size_t ESC_POS_Template::size() {
+    return length;
+}
+
+uint8_t ESC_POS_Template::fieldCount() {
+    return fields;
+}
+
+// Add an instruction, leaving room for OP_END
+bool ESC_POS_Template::append(uint8_t op, const uint8_t *data, size_t len) {
+    if(length + 1 + len + 1 > capacity) return false;
+    program[length++] = op;
+    memcpy(program + length, data, len);
+    length += len;
+    return true;
+}
+
+// text[0] is left free for the length byte of OP_TEXT
+#define MAX_TEXT 255
+
+bool ESC_POS_Template::compile(const char *layout, bool progMem) {
+    uint8_t text[1 + MAX_TEXT];
+    size_t  textLen = 0;
+    bool    ok = true;
+    char    c;
+
+    length   = 0;
+    fields   = 0;
+    compiled = false;
+    if(capacity < 1) return false; // No room for OP_END
+    do {
+        c = progMem ? pgm_read_byte(layout) : *layout;
+        layout++;
+
+        bool tag = (c == '{');
+        if(tag && ((progMem ? pgm_read_byte(layout) : *layout) == '{')) {
+            layout++; // "{{" is a plain '{'
+            tag = false;
+        }
+        if(!tag && c) {
+            text[1 + textLen++] = c;
+            if(textLen < MAX_TEXT) continue;
+        }
+
+        // End of a text segment
+        if(textLen) {
+            text[0] = textLen;
+            ok = append(OP_TEXT, text, 1 + textLen);
+            textLen = 0;
+        }
+        if(!ok || !tag) continue;
+
+        // Read the tag up to '}'
+        char name[8], t;
+        uint8_t n = 0;
+        while(ok) {
+            t = progMem ? pgm_read_byte(layout) : *layout;
+            layout++;
+            if(t == '}') break;
+            if(!t || (n == sizeof(name) - 1)) ok = false;
+            else name[n++] = t;
+        }
+        name[n] = '\0';
+        if(!ok || !n) {
+            ok = false;
+        } else if(isdigit(name[0])) {
+            // {n}, {n:W} or {n:aW}
+            uint8_t op[3] = { 0, 0, '<' };
+            char *p;
+            unsigned long v = strtoul(name, &p, 10);
+            op[0] = v;
+            ok = (v < 255);
+            if(*p == ':') {
+                p++;
+                if((*p == '<') || (*p == '>') || (*p == '^')) op[2] = *p++;
+                char *digits = p;
+                v = strtoul(p, &p, 10);
+                op[1] = v;
+                ok = ok && (v < 256) && (p > digits);
+            }
+            ok = ok && !*p && append(OP_FIELD, op, sizeof(op));
+            if(ok && (op[0] >= fields)) fields = op[0] + 1;
+        } else {
+            ok = (n == 1) && strchr("<^>BbUuIiHhSMLC", name[0]) &&
+                append(OP_STYLE, (const uint8_t *)name, 1);
+        }
+    } while(ok && c);
+
+    if(!ok) {
+        length = 0;
+        fields = 0;
+        return false;
+    }
+    program[length] = OP_END; // append() left room
+    compiled = true;
+    return true;
+}
+
+// Print a field in width columns, cut or padded with spaces
+static void printField(ESC_POS_Printer &printer, const char *text,
+        uint8_t width, uint8_t align) {
+    static const uint8_t spaces[16] = {
+        ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',
+        ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '
+    };
+    size_t len = text ? strlen(text) : 0, before = 0, after = 0;
+
+    if(width) {
+        if(len > width) len = width;
+        size_t pad = width - len;
+        if(align == '>')      before = pad;
+        else if(align == '^') before = pad / 2;
+        after = pad - before;
+    }
+    for(size_t n; before > 0; before -= n) {
+        n = min(before, sizeof(spaces));
+        printer.write(spaces, n);
+    }
+    if(len) printer.write((const uint8_t *)text, len);
+    for(size_t n; after > 0; after -= n) {
+        n = min(after, sizeof(spaces));
+        printer.write(spaces, n);
+    }
+}
+
+// Print the template with fields[0] to fields[count - 1] filled in.
+// Missing or NULL fields print as blanks.  Returns false if nothing has
+// been compiled; an empty layout prints nothing.
+bool ESC_POS_Template::print(
+        ESC_POS_Printer &printer, const char *const fields[], uint8_t count) {
+    if(!compiled) return false;
+
+    for(const uint8_t *p = program; *p != OP_END; ) {
+        switch(*p++) {
+            case OP_TEXT:
+                printer.write(p + 1, p[0]);
+                p += 1 + p[0];
+                break;
+            case OP_FIELD:
+                printField(printer, (p[0] < count) ? fields[p[0]] : NULL, p[1], p[2]);
+                p += 3;
+                break;
+            case OP_STYLE:
+                switch(*p++) {
+                    case '<': printer.justify('L');      break;
+                    case '^': printer.justify('C');      break;
+                    case '>': printer.justify('R');      break;
+                    case 'B': printer.boldOn();          break;
+                    case 'b': printer.boldOff();         break;
+                    case 'U': printer.underlineOn();     break;
+                    case 'u': printer.underlineOff();    break;
+                    case 'I': printer.inverseOn();       break;
+                    case 'i': printer.inverseOff();      break;
+                    case 'H': printer.doubleHeightOn();  break;
+                    case 'h': printer.doubleHeightOff(); break;
+                    case 'S': printer.setSize('S');      break;
+                    case 'M': printer.setSize('M');      break;
+                    case 'L': printer.setSize('L');      break;
+                    case 'C': printer.cut();             break;
+                }
+                break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+/*------------------------------------------------------------------------
+  Receipt templates for ESC_POS_Printer.
+
+  A layout is compiled once into a small program in a caller supplied
+  buffer.  Printing it streams the fixed text and style changes and
+  fills in the fields, so a repeated receipt costs little more than its
+  variable data.  Nothing is allocated on the heap.
+
+  Layout syntax, everything else is printed as it is:
+    {0} {1} ...   field by number, as long as it is
+    {n:W}         field n in W columns, left aligned (cut if longer)
+    {n:>W}        right aligned,  {n:^W} centred,  {n:<W} left aligned
+    {<} {^} {>}   justify left, centre, right
+    {B} {b}       bold on, off          {U} {u}  underline on, off
+    {I} {i}       inverse on, off       {H} {h}  double height on, off
+    {S} {M} {L}   small, medium, large text (as setSize())
+    {C}           cut (or feed to the tear bar)
+    {{            a '{'
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_TEMPLATE_H
+#define ESC_POS_TEMPLATE_H
+
+#include "ESC_POS_Printer.h"
+
+class ESC_POS_Template {
+
+    public:
+
+        // The program is built in buffer; a layout needs about its own
+        // length plus three bytes per field and style change.
+        ESC_POS_Template(uint8_t *buffer, size_t size);
+
+        // Returns false if the layout has a syntax error or its program
+        // does not fit in the buffer.
+        bool
+            compile(const char *layout),
+            compile(const __FlashStringHelper *layout),
+            print(ESC_POS_Printer &printer, const char *const fields[],
+                    uint8_t count);
+        size_t
+            size();        // Bytes of program
+        uint8_t
+            fieldCount();  // Highest field number used plus one
+
+    private:
+
+        uint8_t
+            *program,
+            fields;
+        size_t
+            capacity,
+            length;
+        bool
+            compiled,      // program holds a whole program, maybe empty
+            compile(const char *layout, bool progMem),
+            append(uint8_t op, const uint8_t *data, size_t len);
+};
+
+#endif // ESC_POS_TEMPLATE_H
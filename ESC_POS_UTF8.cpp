@@ -0,0 +1,536 @@
+/*------------------------------------------------------------------------
+  UTF-8 text for ESC_POS_Printer.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_UTF8.h"
+
+#define ASCII_ESC 27
+
+// Unicode code points of bytes 0x80-0xFF in each code page, 0 for bytes
+// that have none.
+
+static const uint16_t tableCP437[128] PROGMEM = {
+    0x00C7, 0x00FC, 0x00E9, 0x00E2, 0x00E4, 0x00E0, 0x00E5, 0x00E7,
+    0x00EA, 0x00EB, 0x00E8, 0x00EF, 0x00EE, 0x00EC, 0x00C4, 0x00C5,
+    0x00C9, 0x00E6, 0x00C6, 0x00F4, 0x00F6, 0x00F2, 0x00FB, 0x00F9,
+    0x00FF, 0x00D6, 0x00DC, 0x00A2, 0x00A3, 0x00A5, 0x20A7, 0x0192,
+    0x00E1, 0x00ED, 0x00F3, 0x00FA, 0x00F1, 0x00D1, 0x00AA, 0x00BA,
+    0x00BF, 0x2310, 0x00AC, 0x00BD, 0x00BC, 0x00A1, 0x00AB, 0x00BB,
+    0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x2561, 0x2562, 0x2556,
+    0x2555, 0x2563, 0x2551, 0x2557, 0x255D, 0x255C, 0x255B, 0x2510,
+    0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x255E, 0x255F,
+    0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x2567,
+    0x2568, 0x2564, 0x2565, 0x2559, 0x2558, 0x2552, 0x2553, 0x256B,
+    0x256A, 0x2518, 0x250C, 0x2588, 0x2584, 0x258C, 0x2590, 0x2580,
+    0x03B1, 0x00DF, 0x0393, 0x03C0, 0x03A3, 0x03C3, 0x00B5, 0x03C4,
+    0x03A6, 0x0398, 0x03A9, 0x03B4, 0x221E, 0x03C6, 0x03B5, 0x2229,
+    0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248,
+    0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0,
+};
+
+static const uint16_t tableCP850[128] PROGMEM = {
+    0x00C7, 0x00FC, 0x00E9, 0x00E2, 0x00E4, 0x00E0, 0x00E5, 0x00E7,
+    0x00EA, 0x00EB, 0x00E8, 0x00EF, 0x00EE, 0x00EC, 0x00C4, 0x00C5,
+    0x00C9, 0x00E6, 0x00C6, 0x00F4, 0x00F6, 0x00F2, 0x00FB, 0x00F9,
+    0x00FF, 0x00D6, 0x00DC, 0x00F8, 0x00A3, 0x00D8, 0x00D7, 0x0192,
+    0x00E1, 0x00ED, 0x00F3, 0x00FA, 0x00F1, 0x00D1, 0x00AA, 0x00BA,
+    0x00BF, 0x00AE, 0x00AC, 0x00BD, 0x00BC, 0x00A1, 0x00AB, 0x00BB,
+    0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x00C1, 0x00C2, 0x00C0,
+    0x00A9, 0x2563, 0x2551, 0x2557, 0x255D, 0x00A2, 0x00A5, 0x2510,
+    0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x00E3, 0x00C3,
+    0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x00A4,
+    0x00F0, 0x00D0, 0x00CA, 0x00CB, 0x00C8, 0x0131, 0x00CD, 0x00CE,
+    0x00CF, 0x2518, 0x250C, 0x2588, 0x2584, 0x00A6, 0x00CC, 0x2580,
+    0x00D3, 0x00DF, 0x00D4, 0x00D2, 0x00F5, 0x00D5, 0x00B5, 0x00FE,
+    0x00DE, 0x00DA, 0x00DB, 0x00D9, 0x00FD, 0x00DD, 0x00AF, 0x00B4,
+    0x00AD, 0x00B1, 0x2017, 0x00BE, 0x00B6, 0x00A7, 0x00F7, 0x00B8,
+    0x00B0, 0x00A8, 0x00B7, 0x00B9, 0x00B3, 0x00B2, 0x25A0, 0x00A0,
+};
+
+static const uint16_t tableCP852[128] PROGMEM = {
+    0x00C7, 0x00FC, 0x00E9, 0x00E2, 0x00E4, 0x016F, 0x0107, 0x00E7,
+    0x0142, 0x00EB, 0x0150, 0x0151, 0x00EE, 0x0179, 0x00C4, 0x0106,
+    0x00C9, 0x0139, 0x013A, 0x00F4, 0x00F6, 0x013D, 0x013E, 0x015A,
+    0x015B, 0x00D6, 0x00DC, 0x0164, 0x0165, 0x0141, 0x00D7, 0x010D,
+    0x00E1, 0x00ED, 0x00F3, 0x00FA, 0x0104, 0x0105, 0x017D, 0x017E,
+    0x0118, 0x0119, 0x00AC, 0x017A, 0x010C, 0x015F, 0x00AB, 0x00BB,
+    0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x00C1, 0x00C2, 0x011A,
+    0x015E, 0x2563, 0x2551, 0x2557, 0x255D, 0x017B, 0x017C, 0x2510,
+    0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x0102, 0x0103,
+    0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x00A4,
+    0x0111, 0x0110, 0x010E, 0x00CB, 0x010F, 0x0147, 0x00CD, 0x00CE,
+    0x011B, 0x2518, 0x250C, 0x2588, 0x2584, 0x0162, 0x016E, 0x2580,
+    0x00D3, 0x00DF, 0x00D4, 0x0143, 0x0144, 0x0148, 0x0160, 0x0161,
+    0x0154, 0x00DA, 0x0155, 0x0170, 0x00FD, 0x00DD, 0x0163, 0x00B4,
+    0x00AD, 0x02DD, 0x02DB, 0x02C7, 0x02D8, 0x00A7, 0x00F7, 0x00B8,
+    0x00B0, 0x00A8, 0x02D9, 0x0171, 0x0158, 0x0159, 0x25A0, 0x00A0,
+};
+
+static const uint16_t tableCP858[128] PROGMEM = {
+    0x00C7, 0x00FC, 0x00E9, 0x00E2, 0x00E4, 0x00E0, 0x00E5, 0x00E7,
+    0x00EA, 0x00EB, 0x00E8, 0x00EF, 0x00EE, 0x00EC, 0x00C4, 0x00C5,
+    0x00C9, 0x00E6, 0x00C6, 0x00F4, 0x00F6, 0x00F2, 0x00FB, 0x00F9,
+    0x00FF, 0x00D6, 0x00DC, 0x00F8, 0x00A3, 0x00D8, 0x00D7, 0x0192,
+    0x00E1, 0x00ED, 0x00F3, 0x00FA, 0x00F1, 0x00D1, 0x00AA, 0x00BA,
+    0x00BF, 0x00AE, 0x00AC, 0x00BD, 0x00BC, 0x00A1, 0x00AB, 0x00BB,
+    0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x00C1, 0x00C2, 0x00C0,
+    0x00A9, 0x2563, 0x2551, 0x2557, 0x255D, 0x00A2, 0x00A5, 0x2510,
+    0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x00E3, 0x00C3,
+    0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x00A4,
+    0x00F0, 0x00D0, 0x00CA, 0x00CB, 0x00C8, 0x20AC, 0x00CD, 0x00CE,
+    0x00CF, 0x2518, 0x250C, 0x2588, 0x2584, 0x00A6, 0x00CC, 0x2580,
+    0x00D3, 0x00DF, 0x00D4, 0x00D2, 0x00F5, 0x00D5, 0x00B5, 0x00FE,
+    0x00DE, 0x00DA, 0x00DB, 0x00D9, 0x00FD, 0x00DD, 0x00AF, 0x00B4,
+    0x00AD, 0x00B1, 0x2017, 0x00BE, 0x00B6, 0x00A7, 0x00F7, 0x00B8,
+    0x00B0, 0x00A8, 0x00B7, 0x00B9, 0x00B3, 0x00B2, 0x25A0, 0x00A0,
+};
+
+static const uint16_t tableCP866[128] PROGMEM = {
+    0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,
+    0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,
+    0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,
+    0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,
+    0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+    0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+    0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x2561, 0x2562, 0x2556,
+    0x2555, 0x2563, 0x2551, 0x2557, 0x255D, 0x255C, 0x255B, 0x2510,
+    0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x255E, 0x255F,
+    0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x2567,
+    0x2568, 0x2564, 0x2565, 0x2559, 0x2558, 0x2552, 0x2553, 0x256B,
+    0x256A, 0x2518, 0x250C, 0x2588, 0x2584, 0x258C, 0x2590, 0x2580,
+    0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,
+    0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F,
+    0x0401, 0x0451, 0x0404, 0x0454, 0x0407, 0x0457, 0x040E, 0x045E,
+    0x00B0, 0x2219, 0x00B7, 0x221A, 0x2116, 0x00A4, 0x25A0, 0x00A0,
+};
+
+static const uint16_t tableCP737[128] PROGMEM = {
+    0x0391, 0x0392, 0x0393, 0x0394, 0x0395, 0x0396, 0x0397, 0x0398,
+    0x0399, 0x039A, 0x039B, 0x039C, 0x039D, 0x039E, 0x039F, 0x03A0,
+    0x03A1, 0x03A3, 0x03A4, 0x03A5, 0x03A6, 0x03A7, 0x03A8, 0x03A9,
+    0x03B1, 0x03B2, 0x03B3, 0x03B4, 0x03B5, 0x03B6, 0x03B7, 0x03B8,
+    0x03B9, 0x03BA, 0x03BB, 0x03BC, 0x03BD, 0x03BE, 0x03BF, 0x03C0,
+    0x03C1, 0x03C3, 0x03C2, 0x03C4, 0x03C5, 0x03C6, 0x03C7, 0x03C8,
+    0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x2561, 0x2562, 0x2556,
+    0x2555, 0x2563, 0x2551, 0x2557, 0x255D, 0x255C, 0x255B, 0x2510,
+    0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x255E, 0x255F,
+    0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x2567,
+    0x2568, 0x2564, 0x2565, 0x2559, 0x2558, 0x2552, 0x2553, 0x256B,
+    0x256A, 0x2518, 0x250C, 0x2588, 0x2584, 0x258C, 0x2590, 0x2580,
+    0x03C9, 0x03AC, 0x03AD, 0x03AE, 0x03CA, 0x03AF, 0x03CC, 0x03CD,
+    0x03CB, 0x03CE, 0x0386, 0x0388, 0x0389, 0x038A, 0x038C, 0x038E,
+    0x038F, 0x00B1, 0x2265, 0x2264, 0x03AA, 0x03AB, 0x00F7, 0x2248,
+    0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0,
+};
+
+static const uint16_t tableCP857[128] PROGMEM = {
+    0x00C7, 0x00FC, 0x00E9, 0x00E2, 0x00E4, 0x00E0, 0x00E5, 0x00E7,
+    0x00EA, 0x00EB, 0x00E8, 0x00EF, 0x00EE, 0x0131, 0x00C4, 0x00C5,
+    0x00C9, 0x00E6, 0x00C6, 0x00F4, 0x00F6, 0x00F2, 0x00FB, 0x00F9,
+    0x0130, 0x00D6, 0x00DC, 0x00F8, 0x00A3, 0x00D8, 0x015E, 0x015F,
+    0x00E1, 0x00ED, 0x00F3, 0x00FA, 0x00F1, 0x00D1, 0x011E, 0x011F,
+    0x00BF, 0x00AE, 0x00AC, 0x00BD, 0x00BC, 0x00A1, 0x00AB, 0x00BB,
+    0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x00C1, 0x00C2, 0x00C0,
+    0x00A9, 0x2563, 0x2551, 0x2557, 0x255D, 0x00A2, 0x00A5, 0x2510,
+    0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x00E3, 0x00C3,
+    0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x00A4,
+    0x00BA, 0x00AA, 0x00CA, 0x00CB, 0x00C8, 0x0000, 0x00CD, 0x00CE,
+    0x00CF, 0x2518, 0x250C, 0x2588, 0x2584, 0x00A6, 0x00CC, 0x2580,
+    0x00D3, 0x00DF, 0x00D4, 0x00D2, 0x00F5, 0x00D5, 0x00B5, 0x0000,
+    0x00D7, 0x00DA, 0x00DB, 0x00D9, 0x00EC, 0x00FF, 0x00AF, 0x00B4,
+    0x00AD, 0x00B1, 0x0000, 0x00BE, 0x00B6, 0x00A7, 0x00F7, 0x00B8,
+    0x00B0, 0x00A8, 0x00B7, 0x00B9, 0x00B3, 0x00B2, 0x25A0, 0x00A0,
+};
+
+static const uint16_t tableWCP1251[128] PROGMEM = {
+    0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,
+    0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x0000, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,
+    0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7,
+    0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,
+    0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7,
+    0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457,
+    0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,
+    0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,
+    0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,
+    0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,
+    0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+    0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+    0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,
+    0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F,
+};
+
+static const uint16_t tableWCP1252[128] PROGMEM = {
+    0x20AC, 0x0000, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x0000, 0x017D, 0x0000,
+    0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x0000, 0x017E, 0x0178,
+    0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7,
+    0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+    0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7,
+    0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+    0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7,
+    0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+    0x00D0, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7,
+    0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x00DF,
+    0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7,
+    0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+    0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7,
+    0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00FF,
+};
+
+static const uint16_t tableWCP1253[128] PROGMEM = {
+    0x20AC, 0x0000, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x0000, 0x2030, 0x0000, 0x2039, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x0000, 0x2122, 0x0000, 0x203A, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x00A0, 0x0385, 0x0386, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7,
+    0x00A8, 0x00A9, 0x0000, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x2015,
+    0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x0384, 0x00B5, 0x00B6, 0x00B7,
+    0x0388, 0x0389, 0x038A, 0x00BB, 0x038C, 0x00BD, 0x038E, 0x038F,
+    0x0390, 0x0391, 0x0392, 0x0393, 0x0394, 0x0395, 0x0396, 0x0397,
+    0x0398, 0x0399, 0x039A, 0x039B, 0x039C, 0x039D, 0x039E, 0x039F,
+    0x03A0, 0x03A1, 0x0000, 0x03A3, 0x03A4, 0x03A5, 0x03A6, 0x03A7,
+    0x03A8, 0x03A9, 0x03AA, 0x03AB, 0x03AC, 0x03AD, 0x03AE, 0x03AF,
+    0x03B0, 0x03B1, 0x03B2, 0x03B3, 0x03B4, 0x03B5, 0x03B6, 0x03B7,
+    0x03B8, 0x03B9, 0x03BA, 0x03BB, 0x03BC, 0x03BD, 0x03BE, 0x03BF,
+    0x03C0, 0x03C1, 0x03C2, 0x03C3, 0x03C4, 0x03C5, 0x03C6, 0x03C7,
+    0x03C8, 0x03C9, 0x03CA, 0x03CB, 0x03CC, 0x03CD, 0x03CE, 0x0000,
+};
+
+static const uint16_t *tableFor(uint8_t page) {
+    switch(page) {
+        case CODEPAGE_CP437:   return tableCP437;
+        case CODEPAGE_CP737:   return tableCP737;
+        case CODEPAGE_CP850:   return tableCP850;
+        case CODEPAGE_CP852:   return tableCP852;
+        case CODEPAGE_CP857:   return tableCP857;
+        case CODEPAGE_CP858:   return tableCP858;
+        case CODEPAGE_CP866:   return tableCP866;
+        case CODEPAGE_WCP1251: return tableWCP1251;
+        case CODEPAGE_WCP1252: return tableWCP1252;
+        case CODEPAGE_WCP1253: return tableWCP1253;
+    }
+    return NULL;
+}
+
+static const uint8_t allPages[] = {
+    CODEPAGE_CP437, CODEPAGE_CP850, CODEPAGE_CP858, CODEPAGE_WCP1252,
+    CODEPAGE_CP852, CODEPAGE_CP857, CODEPAGE_CP737, CODEPAGE_WCP1253,
+    CODEPAGE_CP866, CODEPAGE_WCP1251
+};
+
+// Every code point in the tables above, in order, with the pages that
+// have it: bit i for allPages[i].  Made from the tables, so one binary
+// search answers for all pages at once.
+struct PageSet {
+    uint16_t codepoint, pages;
+};
+
+static const PageSet pageSets[] PROGMEM = {
+    { 0x00A0, 0x3FF }, { 0x00A1, 0x02F }, { 0x00A2, 0x02F }, { 0x00A3, 0x0AF },
+    { 0x00A4, 0x3BE }, { 0x00A5, 0x0AF }, { 0x00A6, 0x2AE }, { 0x00A7, 0x2BE },
+    { 0x00A8, 0x0BE }, { 0x00A9, 0x2AE }, { 0x00AA, 0x02F }, { 0x00AB, 0x2BF },
+    { 0x00AC, 0x2BF }, { 0x00AD, 0x2BE }, { 0x00AE, 0x2AE }, { 0x00AF, 0x02E },
+    { 0x00B0, 0x3FF }, { 0x00B1, 0x2EF }, { 0x00B2, 0x0EF }, { 0x00B3, 0x0AE },
+    { 0x00B4, 0x03E }, { 0x00B5, 0x2AF }, { 0x00B6, 0x2AE }, { 0x00B7, 0x3EF },
+    { 0x00B8, 0x03E }, { 0x00B9, 0x02E }, { 0x00BA, 0x02F }, { 0x00BB, 0x2BF },
+    { 0x00BC, 0x02F }, { 0x00BD, 0x0AF }, { 0x00BE, 0x02E }, { 0x00BF, 0x02F },
+    { 0x00C0, 0x02E }, { 0x00C1, 0x03E }, { 0x00C2, 0x03E }, { 0x00C3, 0x02E },
+    { 0x00C4, 0x03F }, { 0x00C5, 0x02F }, { 0x00C6, 0x02F }, { 0x00C7, 0x03F },
+    { 0x00C8, 0x02E }, { 0x00C9, 0x03F }, { 0x00CA, 0x02E }, { 0x00CB, 0x03E },
+    { 0x00CC, 0x02E }, { 0x00CD, 0x03E }, { 0x00CE, 0x03E }, { 0x00CF, 0x02E },
+    { 0x00D0, 0x00E }, { 0x00D1, 0x02F }, { 0x00D2, 0x02E }, { 0x00D3, 0x03E },
+    { 0x00D4, 0x03E }, { 0x00D5, 0x02E }, { 0x00D6, 0x03F }, { 0x00D7, 0x03E },
+    { 0x00D8, 0x02E }, { 0x00D9, 0x02E }, { 0x00DA, 0x03E }, { 0x00DB, 0x02E },
+    { 0x00DC, 0x03F }, { 0x00DD, 0x01E }, { 0x00DE, 0x00E }, { 0x00DF, 0x03F },
+    { 0x00E0, 0x02F }, { 0x00E1, 0x03F }, { 0x00E2, 0x03F }, { 0x00E3, 0x02E },
+    { 0x00E4, 0x03F }, { 0x00E5, 0x02F }, { 0x00E6, 0x02F }, { 0x00E7, 0x03F },
+    { 0x00E8, 0x02F }, { 0x00E9, 0x03F }, { 0x00EA, 0x02F }, { 0x00EB, 0x03F },
+    { 0x00EC, 0x02F }, { 0x00ED, 0x03F }, { 0x00EE, 0x03F }, { 0x00EF, 0x02F },
+    { 0x00F0, 0x00E }, { 0x00F1, 0x02F }, { 0x00F2, 0x02F }, { 0x00F3, 0x03F },
+    { 0x00F4, 0x03F }, { 0x00F5, 0x02E }, { 0x00F6, 0x03F }, { 0x00F7, 0x07F },
+    { 0x00F8, 0x02E }, { 0x00F9, 0x02F }, { 0x00FA, 0x03F }, { 0x00FB, 0x02F },
+    { 0x00FC, 0x03F }, { 0x00FD, 0x01E }, { 0x00FE, 0x00E }, { 0x00FF, 0x02F },
+    { 0x0102, 0x010 }, { 0x0103, 0x010 }, { 0x0104, 0x010 }, { 0x0105, 0x010 },
+    { 0x0106, 0x010 }, { 0x0107, 0x010 }, { 0x010C, 0x010 }, { 0x010D, 0x010 },
+    { 0x010E, 0x010 }, { 0x010F, 0x010 }, { 0x0110, 0x010 }, { 0x0111, 0x010 },
+    { 0x0118, 0x010 }, { 0x0119, 0x010 }, { 0x011A, 0x010 }, { 0x011B, 0x010 },
+    { 0x011E, 0x020 }, { 0x011F, 0x020 }, { 0x0130, 0x020 }, { 0x0131, 0x022 },
+    { 0x0139, 0x010 }, { 0x013A, 0x010 }, { 0x013D, 0x010 }, { 0x013E, 0x010 },
+    { 0x0141, 0x010 }, { 0x0142, 0x010 }, { 0x0143, 0x010 }, { 0x0144, 0x010 },
+    { 0x0147, 0x010 }, { 0x0148, 0x010 }, { 0x0150, 0x010 }, { 0x0151, 0x010 },
+    { 0x0152, 0x008 }, { 0x0153, 0x008 }, { 0x0154, 0x010 }, { 0x0155, 0x010 },
+    { 0x0158, 0x010 }, { 0x0159, 0x010 }, { 0x015A, 0x010 }, { 0x015B, 0x010 },
+    { 0x015E, 0x030 }, { 0x015F, 0x030 }, { 0x0160, 0x018 }, { 0x0161, 0x018 },
+    { 0x0162, 0x010 }, { 0x0163, 0x010 }, { 0x0164, 0x010 }, { 0x0165, 0x010 },
+    { 0x016E, 0x010 }, { 0x016F, 0x010 }, { 0x0170, 0x010 }, { 0x0171, 0x010 },
+    { 0x0178, 0x008 }, { 0x0179, 0x010 }, { 0x017A, 0x010 }, { 0x017B, 0x010 },
+    { 0x017C, 0x010 }, { 0x017D, 0x018 }, { 0x017E, 0x018 }, { 0x0192, 0x08F },
+    { 0x02C6, 0x008 }, { 0x02C7, 0x010 }, { 0x02D8, 0x010 }, { 0x02D9, 0x010 },
+    { 0x02DB, 0x010 }, { 0x02DC, 0x008 }, { 0x02DD, 0x010 }, { 0x0384, 0x080 },
+    { 0x0385, 0x080 }, { 0x0386, 0x0C0 }, { 0x0388, 0x0C0 }, { 0x0389, 0x0C0 },
+    { 0x038A, 0x0C0 }, { 0x038C, 0x0C0 }, { 0x038E, 0x0C0 }, { 0x038F, 0x0C0 },
+    { 0x0390, 0x080 }, { 0x0391, 0x0C0 }, { 0x0392, 0x0C0 }, { 0x0393, 0x0C1 },
+    { 0x0394, 0x0C0 }, { 0x0395, 0x0C0 }, { 0x0396, 0x0C0 }, { 0x0397, 0x0C0 },
+    { 0x0398, 0x0C1 }, { 0x0399, 0x0C0 }, { 0x039A, 0x0C0 }, { 0x039B, 0x0C0 },
+    { 0x039C, 0x0C0 }, { 0x039D, 0x0C0 }, { 0x039E, 0x0C0 }, { 0x039F, 0x0C0 },
+    { 0x03A0, 0x0C0 }, { 0x03A1, 0x0C0 }, { 0x03A3, 0x0C1 }, { 0x03A4, 0x0C0 },
+    { 0x03A5, 0x0C0 }, { 0x03A6, 0x0C1 }, { 0x03A7, 0x0C0 }, { 0x03A8, 0x0C0 },
+    { 0x03A9, 0x0C1 }, { 0x03AA, 0x0C0 }, { 0x03AB, 0x0C0 }, { 0x03AC, 0x0C0 },
+    { 0x03AD, 0x0C0 }, { 0x03AE, 0x0C0 }, { 0x03AF, 0x0C0 }, { 0x03B0, 0x080 },
+    { 0x03B1, 0x0C1 }, { 0x03B2, 0x0C0 }, { 0x03B3, 0x0C0 }, { 0x03B4, 0x0C1 },
+    { 0x03B5, 0x0C1 }, { 0x03B6, 0x0C0 }, { 0x03B7, 0x0C0 }, { 0x03B8, 0x0C0 },
+    { 0x03B9, 0x0C0 }, { 0x03BA, 0x0C0 }, { 0x03BB, 0x0C0 }, { 0x03BC, 0x0C0 },
+    { 0x03BD, 0x0C0 }, { 0x03BE, 0x0C0 }, { 0x03BF, 0x0C0 }, { 0x03C0, 0x0C1 },
+    { 0x03C1, 0x0C0 }, { 0x03C2, 0x0C0 }, { 0x03C3, 0x0C1 }, { 0x03C4, 0x0C1 },
+    { 0x03C5, 0x0C0 }, { 0x03C6, 0x0C1 }, { 0x03C7, 0x0C0 }, { 0x03C8, 0x0C0 },
+    { 0x03C9, 0x0C0 }, { 0x03CA, 0x0C0 }, { 0x03CB, 0x0C0 }, { 0x03CC, 0x0C0 },
+    { 0x03CD, 0x0C0 }, { 0x03CE, 0x0C0 }, { 0x0401, 0x300 }, { 0x0402, 0x200 },
+    { 0x0403, 0x200 }, { 0x0404, 0x300 }, { 0x0405, 0x200 }, { 0x0406, 0x200 },
+    { 0x0407, 0x300 }, { 0x0408, 0x200 }, { 0x0409, 0x200 }, { 0x040A, 0x200 },
+    { 0x040B, 0x200 }, { 0x040C, 0x200 }, { 0x040E, 0x300 }, { 0x040F, 0x200 },
+    { 0x0410, 0x300 }, { 0x0411, 0x300 }, { 0x0412, 0x300 }, { 0x0413, 0x300 },
+    { 0x0414, 0x300 }, { 0x0415, 0x300 }, { 0x0416, 0x300 }, { 0x0417, 0x300 },
+    { 0x0418, 0x300 }, { 0x0419, 0x300 }, { 0x041A, 0x300 }, { 0x041B, 0x300 },
+    { 0x041C, 0x300 }, { 0x041D, 0x300 }, { 0x041E, 0x300 }, { 0x041F, 0x300 },
+    { 0x0420, 0x300 }, { 0x0421, 0x300 }, { 0x0422, 0x300 }, { 0x0423, 0x300 },
+    { 0x0424, 0x300 }, { 0x0425, 0x300 }, { 0x0426, 0x300 }, { 0x0427, 0x300 },
+    { 0x0428, 0x300 }, { 0x0429, 0x300 }, { 0x042A, 0x300 }, { 0x042B, 0x300 },
+    { 0x042C, 0x300 }, { 0x042D, 0x300 }, { 0x042E, 0x300 }, { 0x042F, 0x300 },
+    { 0x0430, 0x300 }, { 0x0431, 0x300 }, { 0x0432, 0x300 }, { 0x0433, 0x300 },
+    { 0x0434, 0x300 }, { 0x0435, 0x300 }, { 0x0436, 0x300 }, { 0x0437, 0x300 },
+    { 0x0438, 0x300 }, { 0x0439, 0x300 }, { 0x043A, 0x300 }, { 0x043B, 0x300 },
+    { 0x043C, 0x300 }, { 0x043D, 0x300 }, { 0x043E, 0x300 }, { 0x043F, 0x300 },
+    { 0x0440, 0x300 }, { 0x0441, 0x300 }, { 0x0442, 0x300 }, { 0x0443, 0x300 },
+    { 0x0444, 0x300 }, { 0x0445, 0x300 }, { 0x0446, 0x300 }, { 0x0447, 0x300 },
+    { 0x0448, 0x300 }, { 0x0449, 0x300 }, { 0x044A, 0x300 }, { 0x044B, 0x300 },
+    { 0x044C, 0x300 }, { 0x044D, 0x300 }, { 0x044E, 0x300 }, { 0x044F, 0x300 },
+    { 0x0451, 0x300 }, { 0x0452, 0x200 }, { 0x0453, 0x200 }, { 0x0454, 0x300 },
+    { 0x0455, 0x200 }, { 0x0456, 0x200 }, { 0x0457, 0x300 }, { 0x0458, 0x200 },
+    { 0x0459, 0x200 }, { 0x045A, 0x200 }, { 0x045B, 0x200 }, { 0x045C, 0x200 },
+    { 0x045E, 0x300 }, { 0x045F, 0x200 }, { 0x0490, 0x200 }, { 0x0491, 0x200 },
+    { 0x2013, 0x288 }, { 0x2014, 0x288 }, { 0x2015, 0x080 }, { 0x2017, 0x006 },
+    { 0x2018, 0x288 }, { 0x2019, 0x288 }, { 0x201A, 0x288 }, { 0x201C, 0x288 },
+    { 0x201D, 0x288 }, { 0x201E, 0x288 }, { 0x2020, 0x288 }, { 0x2021, 0x288 },
+    { 0x2022, 0x288 }, { 0x2026, 0x288 }, { 0x2030, 0x288 }, { 0x2039, 0x288 },
+    { 0x203A, 0x288 }, { 0x207F, 0x041 }, { 0x20A7, 0x001 }, { 0x20AC, 0x28C },
+    { 0x2116, 0x300 }, { 0x2122, 0x288 }, { 0x2219, 0x141 }, { 0x221A, 0x141 },
+    { 0x221E, 0x001 }, { 0x2229, 0x001 }, { 0x2248, 0x041 }, { 0x2261, 0x001 },
+    { 0x2264, 0x041 }, { 0x2265, 0x041 }, { 0x2310, 0x001 }, { 0x2320, 0x001 },
+    { 0x2321, 0x001 }, { 0x2500, 0x177 }, { 0x2502, 0x177 }, { 0x250C, 0x177 },
+    { 0x2510, 0x177 }, { 0x2514, 0x177 }, { 0x2518, 0x177 }, { 0x251C, 0x177 },
+    { 0x2524, 0x177 }, { 0x252C, 0x177 }, { 0x2534, 0x177 }, { 0x253C, 0x177 },
+    { 0x2550, 0x177 }, { 0x2551, 0x177 }, { 0x2552, 0x141 }, { 0x2553, 0x141 },
+    { 0x2554, 0x177 }, { 0x2555, 0x141 }, { 0x2556, 0x141 }, { 0x2557, 0x177 },
+    { 0x2558, 0x141 }, { 0x2559, 0x141 }, { 0x255A, 0x177 }, { 0x255B, 0x141 },
+    { 0x255C, 0x141 }, { 0x255D, 0x177 }, { 0x255E, 0x141 }, { 0x255F, 0x141 },
+    { 0x2560, 0x177 }, { 0x2561, 0x141 }, { 0x2562, 0x141 }, { 0x2563, 0x177 },
+    { 0x2564, 0x141 }, { 0x2565, 0x141 }, { 0x2566, 0x177 }, { 0x2567, 0x141 },
+    { 0x2568, 0x141 }, { 0x2569, 0x177 }, { 0x256A, 0x141 }, { 0x256B, 0x141 },
+    { 0x256C, 0x177 }, { 0x2580, 0x177 }, { 0x2584, 0x177 }, { 0x2588, 0x177 },
+    { 0x258C, 0x141 }, { 0x2590, 0x141 }, { 0x2591, 0x177 }, { 0x2592, 0x177 },
+    { 0x2593, 0x177 }, { 0x25A0, 0x177 },
+};
+
+// Bit for page in PageSet::pages, 0 for a page without a table
+static uint16_t bitOf(uint8_t page) {
+    for(uint8_t i = 0; i < sizeof(allPages); i++) {
+        if(allPages[i] == page) return 1 << i;
+    }
+    return 0;
+}
+
+// Pages that have c, as PageSet::pages
+static uint16_t pagesWith(uint32_t c) {
+    int lo = 0, hi = sizeof(pageSets) / sizeof(pageSets[0]) - 1;
+
+    while(lo <= hi) {
+        int mid = (lo + hi) / 2;
+        uint16_t m = pgm_read_word(&pageSets[mid].codepoint);
+        if(m == c) return pgm_read_word(&pageSets[mid].pages);
+        if(m < c) lo = mid + 1;
+        else      hi = mid - 1;
+    }
+    return 0;
+}
+
+// Byte that prints c in a code page, or 0 if the page does not have it
+static uint8_t lookup(uint8_t page, uint16_t c) {
+    const uint16_t *table = tableFor(page);
+
+    if(!table) return 0;
+    for(uint8_t i = 0; i < 128; i++) {
+        if(pgm_read_word(&table[i]) == c) return 0x80 + i;
+    }
+    return 0;
+}
+
+// Decode the character at p for looking ahead, leaving the encoder's own
+// state alone.  A sequence cut off by end gives 0.
+static uint32_t peek(const uint8_t *&p, const uint8_t *end) {
+    uint8_t b = *p++;
+
+    if(b < 0x80) return b;
+    uint8_t n = ((b & 0xE0) == 0xC0) ? 1 : ((b & 0xF0) == 0xE0) ? 2 :
+                ((b & 0xF8) == 0xF0) ? 3 : 0;
+    if(!n) return 0xFFFD;
+    uint32_t c = b & (0x3F >> n);
+    while(n--) {
+        if(p == end) return 0;
+        if((*p & 0xC0) != 0x80) return 0xFFFD;
+        c = (c << 6) | (*p++ & 0x3F);
+    }
+    return c;
+}
+
+ESC_POS_UTF8::ESC_POS_UTF8(const uint8_t *codePages, uint8_t count) :
+    pages(codePages ? codePages : allPages),
+    glyphs(NULL),
+    pageCount(codePages ? count : sizeof(allPages)),
+    glyphCount(0), pending(0), partial(0), loaded(0) {
+    page = pageCount ? pages[0] : 0xFF;
+}
+
+void ESC_POS_UTF8::setGlyphs(const ESC_POS_Glyph *glyphs, uint8_t count) {
+    this->glyphs = glyphs;
+    glyphCount   = min(count, (uint8_t)ESC_POS_UTF8_MAX_GLYPHS);
+    loaded       = 0;
+}
+
+// ESC @ clears downloaded characters.  The code page is left to the
+// printer's shadow state, which ESC @ also invalidates.
+void ESC_POS_UTF8::reset() {
+    loaded = 0;
+}
+
+// The page among has (from pagesWith()) that also has the most of the
+// characters from next on, earlier pages winning ties, or -1 if none of
+// the encoder's pages is in has.  Each character ahead is looked up once.
+int ESC_POS_UTF8::choosePage(uint16_t has, const uint8_t *next,
+        const uint8_t *end) {
+    uint16_t ahead[ESC_POS_UTF8_LOOKAHEAD];
+    uint8_t  count = 0;
+    int      best      = -1;
+    uint8_t  bestScore =  0;
+
+    for(const uint8_t *p = next; (count < ESC_POS_UTF8_LOOKAHEAD) && (p < end); ) {
+        uint32_t d = peek(p, end);
+        if(d >= 0x80) ahead[count++] = pagesWith(d);
+    }
+    for(uint8_t i = 0; i < pageCount; i++) {
+        uint16_t bit = bitOf(pages[i]);
+        if(!(has & bit)) continue;
+        uint8_t score = 0;
+        for(uint8_t n = 0; n < count; n++) {
+            if(ahead[n] & bit) score++;
+        }
+        if((best < 0) || (score > bestScore)) {
+            best      = pages[i];
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+// Print glyph i as a user-defined character, downloading it first if the
+// printer does not have it yet.  Glyph i takes character code '!' + i.
+void ESC_POS_UTF8::printGlyph(ESC_POS_Printer &printer, uint8_t i) {
+    static const uint8_t
+        userOn[]  = { ASCII_ESC, '%', 1 },
+        userOff[] = { ASCII_ESC, '%', 0 };
+    uint8_t code = '!' + i;
+
+    if(!(loaded & (1UL << i))) {
+        uint8_t cmd[6 + sizeof(glyphs[i].columns)] =
+            { ASCII_ESC, '&', 3, code, code, 12 };
+        memcpy_P(cmd + 6, glyphs[i].columns, sizeof(glyphs[i].columns));
+        printer.writeCommands(cmd, sizeof(cmd), 0);
+        loaded |= 1UL << i;
+    }
+    printer.writeCommands(userOn, sizeof(userOn), 0);
+    printer.write(code);
+    printer.writeCommands(userOff, sizeof(userOff), 0);
+}
+
+// Called by the printer with text being printed.  Printable bytes are
+// collected in out and passed back to the printer in runs.  Each write
+// selects its code page once before the first character that needs it,
+// which costs nothing when the printer is known to be on that page.
+void ESC_POS_UTF8::write(ESC_POS_Printer &printer, const uint8_t *text,
+        size_t len) {
+    const uint8_t *p   = text;
+    const uint8_t *end = text + len;
+    uint8_t out[32], n = 0;
+    bool    pageSet = false;
+
+    while(p < end) {
+        uint8_t  b = *p;
+        uint32_t c;
+
+        if(pending) {
+            if((b & 0xC0) == 0x80) {
+                partial = (partial << 6) | (b & 0x3F);
+                p++;
+                if(--pending) continue;
+                c = partial;
+            } else {
+                pending = 0; // Sequence cut short; b is read again
+                c       = 0xFFFD;
+            }
+        } else {
+            p++;
+            if(b < 0x80) {
+                c = b;
+            } else {
+                pending = ((b & 0xE0) == 0xC0) ? 1 : ((b & 0xF0) == 0xE0) ? 2 :
+                          ((b & 0xF8) == 0xF0) ? 3 : 0;
+                if(pending) {
+                    partial = b & (0x3F >> pending);
+                    continue;
+                }
+                c = 0xFFFD;
+            }
+        }
+        if(c > 0xFFFF) c = 0xFFFD; // Tables and glyphs stop at 16 bits
+
+        uint8_t byte = c;
+        if(c >= 0x80) {
+            uint16_t has = pagesWith(c);
+            byte = (has & bitOf(page)) ? lookup(page, c) : 0;
+            if(!byte) {
+                int other = choosePage(has, p, end);
+                if(other >= 0) {
+                    page    = other;
+                    pageSet = false;
+                    byte    = lookup(page, c);
+                }
+            }
+            if(byte && !pageSet) {
+                if(n) printer.write(out, n);
+                n = 0;
+                printer.setCodePage(page);
+                pageSet = true;
+            }
+        }
+        if(!byte && (c != 0)) {
+            uint8_t i = 0;
+            while((i < glyphCount) && (pgm_read_word(&glyphs[i].codepoint) != c)) i++;
+            if(i < glyphCount) {
+                if(n) printer.write(out, n);
+                n = 0;
+                printGlyph(printer, i);
+                continue;
+            }
+            byte = '?';
+        }
+        out[n++] = byte;
+        if(n == sizeof(out)) {
+            printer.write(out, n);
+            n = 0;
+        }
+    }
+    if(n) printer.write(out, n);
+}
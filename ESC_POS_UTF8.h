@@ -0,0 +1,74 @@
+/*------------------------------------------------------------------------
+  UTF-8 text for ESC_POS_Printer.
+
+  The printer only knows single-byte code pages selected with ESC t.
+  ESC_POS_UTF8 decodes UTF-8 and prints each character from the current
+  code page when it has it.  Otherwise it looks for another page that
+  has it, preferring the one that also covers most of the characters
+  that follow, so mixed text switches pages as seldom as possible.
+  Characters in no page can be drawn as user-defined characters; the
+  rest print as '?'.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_UTF8_H
+#define ESC_POS_UTF8_H
+
+#include "ESC_POS_Printer.h"
+
+// Non-ASCII characters looked at ahead when choosing a code page
+#ifndef ESC_POS_UTF8_LOOKAHEAD
+#define ESC_POS_UTF8_LOOKAHEAD 16
+#endif
+
+// Most user-defined characters, one per glyph given to setGlyphs()
+#define ESC_POS_UTF8_MAX_GLYPHS 32
+
+// A 12 x 24 dot character (font A) for a code point found in no code
+// page.  Columns left to right, 3 bytes each, top byte first, most
+// significant bit at the top -- the layout of ESC &.
+struct ESC_POS_Glyph {
+    uint16_t codepoint;
+    uint8_t  columns[36];
+};
+
+class ESC_POS_UTF8 : public ESC_POS_Encoder {
+
+    public:
+
+        // codePages lists the CODEPAGE_* numbers to use, in order of
+        // preference; they must be among CP437, CP737, CP850, CP852,
+        // CP857, CP858, CP866, WCP1251, WCP1252 and WCP1253, which have
+        // built-in tables.  NULL means all of them, CP437 first.  The
+        // array must stay in memory as long as the encoder.
+        ESC_POS_UTF8(const uint8_t *codePages=NULL, uint8_t count=0);
+
+        // Glyphs (in PROGMEM) downloaded the first time they are needed
+        void
+            setGlyphs(const ESC_POS_Glyph *glyphs, uint8_t count);
+
+        void
+            write(ESC_POS_Printer &printer, const uint8_t *text, size_t len),
+            reset();
+
+    private:
+
+        const uint8_t
+            *pages;
+        const ESC_POS_Glyph
+            *glyphs;
+        uint8_t
+            pageCount,
+            glyphCount,
+            page,          // Code page preferred for the next character
+            pending;       // Continuation bytes still due in a sequence
+        uint32_t
+            partial,       // Code point of a sequence cut by a write
+            loaded;        // Glyphs downloaded since the last reset
+        int
+            choosePage(uint16_t has, const uint8_t *next, const uint8_t *end);
+        void
+            printGlyph(ESC_POS_Printer &printer, uint8_t i);
+};
+
+#endif // ESC_POS_UTF8_H
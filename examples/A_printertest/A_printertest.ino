@@ -82,6 +82,10 @@ void printer_test()
   printer.printBitmap(qrcode_width, qrcode_height, qrcode_data, qrcode_density);
   printer.println(F("ESC_POS_Printer"));
 
+  // Or let the printer draw the QR code.  Call setQRCodeNative(false) on
+  // printers without the GS ( k command to print it as graphics instead.
+  printer.printQRCode("https://github.com/gdsports/ESC_POS_Printer", 4, 'M');
+
   printer.feed(2);
 }
 
@@ -73,9 +73,11 @@ void print_barcode() {
   printer.print(F("CODE 93:"));
   printer.printBarcode("ESC POS", CODE93);
 
-  // CODE 128: 2-255 characters (ASCII 0-127)
+  // CODE 128: up to 80 characters (ASCII 0-127).  Runs of digits are
+  // packed two to a bar character, so long order numbers stay short.
   printer.print(F("CODE128:"));
   printer.printBarcode("ESC POS", CODE128);
+  printer.printBarcode("ORDER 20240117000123", CODE128);
 
   printer.feed(2);
   printer.setDefault(); // Restore printer to defaults
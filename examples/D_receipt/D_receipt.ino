@@ -0,0 +1,52 @@
+/*------------------------------------------------------------------------
+  Teensy 3.6 USB host port with USB printer driver and ESC POS library
+  Print receipts from a template.  The layout is compiled once; each
+  receipt only fills in the fields.
+  ------------------------------------------------------------------------*/
+
+#include "USBHost_t36.h"
+#include "USBPrinter_t36.h"
+#include "ESC_POS_Printer.h"
+#include "ESC_POS_Template.h"
+
+USBHost myusb;
+USBPrinter uprinter(myusb);
+ESC_POS_Printer printer(&uprinter);
+
+uint8_t program[160];
+ESC_POS_Template receipt(program, sizeof(program));
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial && millis() < 3000) delay(1);
+  Serial.println(F("Receipt template"));
+  myusb.begin();
+  Serial.println(F("Init USB"));
+  uprinter.begin();
+  Serial.println(F("Init USB printer"));
+
+  // Fields: 0 order number, 1 item, 2 price, 3 total
+  if (!receipt.compile(F("{^}{L}{B}CAFE{b}{S}\n"
+                         "Order {0}\n"
+                         "{<}{1:24}{2:>8}\n"
+                         "{B}{H}TOTAL{3:>27}{h}{b}\n"
+                         "{C}"))) {
+    Serial.println(F("Template does not compile"));
+  }
+}
+
+void loop() {
+  myusb.Task();
+
+  // Make sure USB printer found and ready
+  if (uprinter) {
+    printer.begin();
+    Serial.println(F("Init ESC POS printer"));
+
+    const char *fields[] = { "1042", "Flat white", "3.50", "3.50" };
+    receipt.print(printer, fields, 4);
+
+    // Do this one time to avoid wasting paper
+    while (1) delay(1);
+  }
+}
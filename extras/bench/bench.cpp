@@ -0,0 +1,412 @@
+/*------------------------------------------------------------------------
+  Throughput benchmark for ESC_POS_Printer on a host.
+
+  Each case drives the printer into a MockStream and reports the bytes
+  sent to the stream, the number of stream write calls and the wall time
+  per run.  Give a substring on the command line to run matching cases
+  only, e.g. "esc_pos_bench bitmap".
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "ESC_POS_Commands.h"
+#include "ESC_POS_ImageCache.h"
+#include "ESC_POS_Receipt.h"
+#include "ESC_POS_Table.h"
+#include "ESC_POS_Template.h"
+#include "ESC_POS_UTF8.h"
+#include "MockStream.h"
+
+#include <chrono>
+#include <stdio.h>
+
+#include "../../examples/A_printertest/qrcode.h"
+
+// Row-major test image: a 384 x 240 logo with white margins around
+// 256 x 160 dots of pseudo random blocks.
+#define IMAGE_WIDTH   384
+#define IMAGE_HEIGHT  240
+#define IMAGE_ROW     (IMAGE_WIDTH / 8)
+
+static uint8_t image[IMAGE_ROW * IMAGE_HEIGHT];
+
+// ESC * 24-dot column data, 384 columns by 4 bands
+#define BANDS_WIDTH   384
+#define BANDS_HEIGHT  96
+
+static uint8_t bands[BANDS_WIDTH * 3 * (BANDS_HEIGHT / 24)];
+
+// Grayscale photo stand-in, one byte per dot: diagonal gradient
+#define GRAY_WIDTH    384
+#define GRAY_HEIGHT   160
+
+static uint8_t gray[GRAY_WIDTH * GRAY_HEIGHT];
+
+// Width and height header for printBitmap(Stream *)
+static uint8_t imageHeader[4] = {
+    IMAGE_WIDTH & 0xFF, IMAGE_WIDTH >> 8, IMAGE_HEIGHT & 0xFF, IMAGE_HEIGHT >> 8
+};
+
+static uint32_t seed = 1;
+
+static uint8_t pseudoRandom() {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+static void makeImages() {
+    for(int y = 40; y < IMAGE_HEIGHT - 40; y += 4) {
+        for(int x = 8; x < IMAGE_ROW - 8; x++) {
+            uint8_t b = pseudoRandom();
+            for(int i = 0; i < 4; i++) image[(y + i) * IMAGE_ROW + x] = b;
+        }
+    }
+    for(size_t i = 0; i < sizeof(bands); i++) bands[i] = pseudoRandom();
+    for(int y = 0; y < GRAY_HEIGHT; y++) {
+        for(int x = 0; x < GRAY_WIDTH; x++) {
+            gray[y * GRAY_WIDTH + x] = (x + y) * 255 / (GRAY_WIDTH + GRAY_HEIGHT);
+        }
+    }
+}
+
+static const char *receiptLines[] = {
+    "2 x Espresso              5.00",
+    "1 x Croissant             2.50",
+    "1 x Orange juice          3.20",
+    "3 x Bagel                 7.50",
+    "1 x Cappuccino            3.10",
+    "Subtotal                 21.30",
+    "Tax                       1.70",
+    "TOTAL                    23.00",
+};
+
+// === Cases ===
+
+static MockStream source; // Feeds the printBitmap(Stream *) cases
+
+static void textPrintln(ESC_POS_Printer &p) {
+    for(int i = 0; i < 5; i++) {
+        for(size_t j = 0; j < sizeof(receiptLines)/sizeof(receiptLines[0]); j++) {
+            p.println(receiptLines[j]);
+        }
+    }
+}
+
+static void textWriteBytes(ESC_POS_Printer &p) {
+    for(int i = 0; i < 5; i++) {
+        for(size_t j = 0; j < sizeof(receiptLines)/sizeof(receiptLines[0]); j++) {
+            for(const char *s = receiptLines[j]; *s; s++) p.write((uint8_t)*s);
+            p.write('\n');
+        }
+    }
+}
+
+static void textNumbers(ESC_POS_Printer &p) {
+    for(int i = 0; i < 40; i++) {
+        p.print(F("Item "));
+        p.print(i);
+        p.print(F(" price "));
+        p.println(i * 1.25, 2);
+    }
+}
+
+static void styleReceipt(ESC_POS_Printer &p) {
+    for(int i = 0; i < 5; i++) {
+        p.setDefault();
+        p.justify('C');
+        p.boldOn();
+        p.setSize('L');
+        p.println(F("CAFE"));
+        p.setSize('S');
+        p.boldOff();
+        p.justify('L');
+        p.underlineOn();
+        p.println(F("Order"));
+        p.underlineOff();
+        p.doubleHeightOn();
+        p.println(F("TOTAL 23.00"));
+        p.doubleHeightOff();
+    }
+}
+
+// styleReceipt() with each group of style changes sent as one sequence
+typedef ESC_POS_Cat<ESC_POS_Justify<'C'>, ESC_POS_BoldOn, ESC_POS_Size<2, 2> >::type Title;
+typedef ESC_POS_Cat<ESC_POS_Size<1, 1>, ESC_POS_BoldOff, ESC_POS_Justify<'L'>,
+                    ESC_POS_Underline<1> >::type Heading;
+typedef ESC_POS_Cat<ESC_POS_Underline<0>, ESC_POS_Size<1, 2> >::type Total;
+
+static void styleSequence(ESC_POS_Printer &p) {
+    for(int i = 0; i < 5; i++) {
+        p.command<Title>();
+        p.println(F("CAFE"));
+        p.command<Heading>();
+        p.println(F("Order"));
+        p.command<Total>();
+        p.println(F("TOTAL 23.00"));
+        p.command<ESC_POS_Size<1, 1> >();
+    }
+}
+
+// styleReceipt() from a template compiled once
+static uint8_t program[128];
+static ESC_POS_Template receipt(program, sizeof(program));
+
+static void styleTemplate(ESC_POS_Printer &p) {
+    static const char *const fields[] = { "CAFE", "23.00" };
+    if(!receipt.size()) {
+        receipt.compile(F("{^}{B}{L}{0}\n{S}{b}{<}{U}Order\n{u}{H}TOTAL {1}\n{h}"));
+    }
+    for(int i = 0; i < 5; i++) {
+        p.setDefault();
+        receipt.print(p, fields, 2);
+    }
+}
+
+// Line items in item / qty / price columns, the item word wrapped
+static const ESC_POS_Column itemColumns[] = {
+    { 20, 'L', true  },
+    {  3, 'R', false },
+    {  7, 'R', false },
+};
+static ESC_POS_Table items(itemColumns, 3);
+
+static void tableRows(ESC_POS_Printer &p) {
+    static const char *const rows[][3] = {
+        { "Flat white",                      "2",  "7.00" },
+        { "Almond croissant, warmed",        "1",  "3.80" },
+        { "Seasonal fruit salad with yoghurt and granola", "1", "6.50" },
+        { "Still water",                     "12", "18.00" },
+    };
+    for(int i = 0; i < 10; i++) items.printRow(p, rows[i % 4]);
+}
+
+// French, Russian and Greek lines, each needing a code page switch
+static void utf8Mixed(ESC_POS_Printer &p) {
+    static ESC_POS_UTF8 utf8;
+    p.setEncoder(&utf8);
+    for(int i = 0; i < 10; i++) {
+        p.println("Cr\xc3\xa8me br\xc3\xbbl\xc3\xa9\xc3\xa9 \xe2\x82\xac" "4,50");
+        p.println("\xd0\xa7\xd0\xb0\xd0\xb9 \xd1\x81 \xd0\xbb\xd0\xb8\xd0\xbc\xd0\xbe\xd0\xbd\xd0\xbe\xd0\xbc");
+        p.println("\xce\x9a\xce\xb1\xcf\x86\xce\xad \xce\xb5\xce\xbb\xce\xbb\xce\xb7\xce\xbd\xce\xb9\xce\xba\xcf\x8c\xcf\x82");
+    }
+    p.setEncoder(NULL);
+}
+
+static void styleSetDefault(ESC_POS_Printer &p) {
+    for(int i = 0; i < 10; i++) p.setDefault();
+}
+
+static void bitmapEscStar8(ESC_POS_Printer &p) {
+    p.printBitmap(qrcode_width, qrcode_height, qrcode_data, qrcode_density);
+}
+
+static void bitmapEscStar24(ESC_POS_Printer &p) {
+    p.printBitmap(BANDS_WIDTH, BANDS_HEIGHT, bands, 2);
+}
+
+static void bitmapEscStar8P(ESC_POS_Printer &p) {
+    p.printBitmap_P(qrcode_width, qrcode_height, qrcode_data, qrcode_density);
+}
+
+static void bitmapRowsRam(ESC_POS_Printer &p) {
+    p.printBitmap(IMAGE_WIDTH, IMAGE_HEIGHT, image, false);
+}
+
+static void bitmapRowsProgMem(ESC_POS_Printer &p) {
+    p.printBitmap(IMAGE_WIDTH, IMAGE_HEIGHT, image, true);
+}
+
+static void bitmapStream(ESC_POS_Printer &p) {
+    source.clear();
+    source.reply(image, sizeof(image));
+    p.printBitmap(IMAGE_WIDTH, IMAGE_HEIGHT, &source);
+}
+
+static void bitmapStreamHeader(ESC_POS_Printer &p) {
+    source.clear();
+    source.reply(imageHeader, sizeof(imageHeader));
+    source.reply(image, sizeof(image));
+    p.printBitmap(&source);
+}
+
+static void image8(ESC_POS_Printer &p) {
+    p.printImage(IMAGE_WIDTH, IMAGE_HEIGHT, image, BITMAP_8DOT);
+}
+
+static void image24(ESC_POS_Printer &p) {
+    p.printImage(IMAGE_WIDTH, IMAGE_HEIGHT, image, BITMAP_24DOT);
+}
+
+static void image24P(ESC_POS_Printer &p) {
+    p.printImage_P(IMAGE_WIDTH, IMAGE_HEIGHT, image, BITMAP_24DOT);
+}
+
+static void imageRaster(ESC_POS_Printer &p) {
+    p.printImage(IMAGE_WIDTH, IMAGE_HEIGHT, image, BITMAP_RASTER);
+}
+
+static void imageStream(ESC_POS_Printer &p) {
+    source.clear();
+    source.reply(image, sizeof(image));
+    p.printImage(IMAGE_WIDTH, IMAGE_HEIGHT, &source, BITMAP_24DOT);
+}
+
+// The same logo on ten receipts, sent each time or stored once
+static void logoBitmap(ESC_POS_Printer &p) {
+    for(int i = 0; i < 10; i++) {
+        p.printImage_P(qrcode_width, qrcode_height, qrcode_data, BITMAP_RASTER);
+    }
+}
+
+static void logoCached(ESC_POS_Printer &p) {
+    ESC_POS_ImageCache cache(p);
+    for(int i = 0; i < 10; i++) {
+        cache.printImage_P(0, qrcode_width, qrcode_height, qrcode_data);
+    }
+}
+
+static void grayOrdered(ESC_POS_Printer &p) {
+    p.printGrayscale(GRAY_WIDTH, GRAY_HEIGHT, gray, DITHER_ORDERED);
+}
+
+static void grayFloydSteinberg(ESC_POS_Printer &p) {
+    p.printGrayscale(GRAY_WIDTH, GRAY_HEIGHT, gray, DITHER_FLOYD_STEINBERG);
+}
+
+static const char qrText[] = "https://github.com/gdsports/ESC_POS_Printer";
+
+static void qrNative(ESC_POS_Printer &p) {
+    p.setQRCodeNative(true);
+    p.printQRCode(qrText);
+}
+
+static void qrSoftware(ESC_POS_Printer &p) {
+    p.setQRCodeNative(false);
+    p.printQRCode(qrText);
+}
+
+// A receipt through the print queue, drained by poll() in
+// ESC_POS_POLL_CHUNK byte writes
+static uint8_t queue[2048];
+
+// A receipt with a dithered header, printed twice: laid out for each
+// copy, or recorded once and replayed
+static void shopReceipt(ESC_POS_Printer &p) {
+    p.printGrayscale(GRAY_WIDTH, GRAY_HEIGHT / 2, gray, DITHER_FLOYD_STEINBERG);
+    styleReceipt(p);
+    tableRows(p);
+    p.printBarcode("0123456789012", CODE128);
+    p.feed(3);
+}
+
+static void copiesRendered(ESC_POS_Printer &p) {
+    shopReceipt(p);
+    shopReceipt(p);
+}
+
+static void copiesReplayed(ESC_POS_Printer &p) {
+    static uint8_t buffer[8192];
+    ESC_POS_Receipt copy(buffer, sizeof(buffer));
+
+    copy.record(p);
+    shopReceipt(p);
+    copy.stop();
+    copy.replay(p, "COPY");
+}
+
+static void queuePoll(ESC_POS_Printer &p) {
+    p.setQueue(queue, sizeof(queue));
+    styleReceipt(p);
+    p.commit();
+    while(p.queued()) p.poll();
+    p.setQueue(NULL, 0);
+}
+
+static void barcode(ESC_POS_Printer &p) {
+    for(int i = 0; i < 5; i++) p.printBarcode("123456789012", CODE128);
+}
+
+struct Case {
+    const char *name;
+    void (*run)(ESC_POS_Printer &);
+};
+
+static const Case cases[] = {
+    { "text_println",          textPrintln        },
+    { "text_write_bytes",      textWriteBytes     },
+    { "text_numbers",          textNumbers        },
+    { "style_receipt",         styleReceipt       },
+    { "style_sequence",        styleSequence      },
+    { "style_template",        styleTemplate      },
+    { "table_rows",            tableRows          },
+    { "utf8_mixed",            utf8Mixed          },
+    { "style_set_default",     styleSetDefault    },
+    { "bitmap_escstar_8",      bitmapEscStar8     },
+    { "bitmap_escstar_24",     bitmapEscStar24    },
+    { "bitmap_escstar_8_P",    bitmapEscStar8P    },
+    { "bitmap_rows_ram",       bitmapRowsRam      },
+    { "bitmap_rows_progmem",   bitmapRowsProgMem  },
+    { "bitmap_stream",         bitmapStream       },
+    { "bitmap_stream_header",  bitmapStreamHeader },
+    { "image_8",               image8             },
+    { "image_24",              image24            },
+    { "image_24_P",            image24P           },
+    { "image_raster",          imageRaster        },
+    { "image_stream",          imageStream        },
+    { "logo_bitmap",           logoBitmap         },
+    { "logo_cached",           logoCached         },
+    { "gray_ordered",          grayOrdered        },
+    { "gray_floyd_steinberg",  grayFloydSteinberg },
+    { "qr_native",             qrNative           },
+    { "qr_software",           qrSoftware         },
+    { "copies_rendered",       copiesRendered     },
+    { "copies_replayed",       copiesReplayed     },
+    { "queue_poll",            queuePoll          },
+    { "barcode",               barcode            },
+};
+
+// === Harness ===
+
+static void runCase(const Case &c) {
+    typedef std::chrono::steady_clock Clock;
+    MockStream      out;
+    ESC_POS_Printer printer(&out);
+
+    out.setCapture(false);
+    printer.begin();
+    printer.commit();
+
+    // One run to count what goes over the wire
+    out.clear();
+    c.run(printer);
+    printer.commit();
+    size_t bytes  = out.bytesWritten();
+    size_t writes = out.writeCalls();
+
+    // Then repeat for at least 200 ms to time it
+    unsigned long runs = 0;
+    Clock::time_point start = Clock::now(), now;
+    do {
+        for(int i = 0; i < 16; i++, runs++) {
+            c.run(printer);
+            printer.commit();
+        }
+        now = Clock::now();
+    } while(now - start < std::chrono::milliseconds(200));
+
+    double us = std::chrono::duration<double, std::micro>(now - start).count()
+        / runs;
+    printf("%-24s %10zu %8zu %10.1f %12.2f\n", c.name, bytes, writes,
+        writes ? (double)bytes / writes : 0.0, us);
+}
+
+int main(int argc, char *argv[]) {
+    const char *filter = (argc > 1) ? argv[1] : "";
+
+    makeImages();
+    printf("%-24s %10s %8s %10s %12s\n",
+        "case", "bytes", "writes", "bytes/wr", "us/run");
+    for(size_t i = 0; i < sizeof(cases)/sizeof(cases[0]); i++) {
+        if(strstr(cases[i].name, filter)) runCase(cases[i]);
+    }
+    return 0;
+}
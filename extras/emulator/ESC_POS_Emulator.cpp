@@ -0,0 +1,786 @@
+/*------------------------------------------------------------------------
+  ESC/POS emulator for host tests of ESC_POS_Printer.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Emulator.h"
+#include "ESC_POS_QRCode.h"
+
+#include <stdio.h>
+
+#define ASCII_HT   9
+#define ASCII_LF  10
+#define ASCII_DLE 16
+#define ASCII_DC2 18
+#define ASCII_DC4 20
+#define ASCII_EOT  4
+#define ASCII_ENQ  5
+#define ASCII_ESC 27
+#define ASCII_FS  28
+#define ASCII_GS  29
+
+#define STRIP_HEIGHT    (24 * 8) // Tallest character, font A at 8 x height
+#define DEFAULT_SPACING 30       // ESC 2 line spacing in dots
+#define TABS_DEFAULT    0xFF     // Every 8 characters
+
+// In command decoding: return 0, for more bytes, unless n are there
+#define NEED(n) if(len < (size_t)(n)) return 0
+
+// 5 x 7 font for ' ' to '~', a byte per column, top dot in bit 0
+static const uint8_t font[95][5] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 },
+    { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 },
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 },
+    { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 },
+    { 0x14, 0x08, 0x3E, 0x08, 0x14 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 },
+    { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 },
+    { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 },
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 },
+    { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E },
+    { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 },
+    { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },
+    { 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E },
+    { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 },
+    { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x49, 0x49, 0x7A },
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 },
+    { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 },
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x0C, 0x02, 0x7F },
+    { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E },
+    { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },
+    { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F },
+    { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F },
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 },
+    { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 },
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 },
+    { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 },
+    { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },
+    { 0x38, 0x44, 0x44, 0x48, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 },
+    { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E },
+    { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 },
+    { 0x20, 0x40, 0x44, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 },
+    { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 },
+    { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },
+    { 0x7C, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7C },
+    { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+    { 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C },
+    { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C },
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C },
+    { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },
+    { 0x00, 0x00, 0x7F, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 },
+    { 0x08, 0x04, 0x08, 0x10, 0x08 }
+};
+
+ESC_POS_Emulator::ESC_POS_Emulator(int width) :
+    pageWidth(width & ~7), stride(width / 8) {
+    strip.resize(STRIP_HEIGHT * stride);
+    clear();
+}
+
+void ESC_POS_Emulator::clear() {
+    bits.clear();
+    pending.clear();
+    replies.clear();
+    qrData.clear();
+    stored.clear();
+    memset(&strip[0], 0, strip.size());
+    y            = 0;
+    drawn        = 0;
+    replyPos     = 0;
+    unknownCount = 0;
+    cutCount     = 0;
+    reset();
+}
+
+// ESC @: settings back to their defaults and the line buffer emptied
+void ESC_POS_Emulator::reset() {
+    x             =  0;
+    lineHeight    =  0;
+    lineRight     =  0;
+    lineUsed      = false;
+    margin        =  0;
+    lineSpacing   = -1;
+    charSpacing   =  0;
+    justify       =  0;
+    widthMul      =  1;
+    heightMul     =  1;
+    fontB         = false;
+    bold          = false;
+    strike        = false;
+    underline     =  0;
+    inverse       = false;
+    userChars     = false;
+    barcodeHeight = 162;
+    barcodeWidth  =  3;
+    barcodeText   =  0;
+    qrModule      =  3;
+    qrEc          = 'L';
+    tabCount      = TABS_DEFAULT;
+    userGlyphs.clear();
+    stored.erase(0);       // GS * image
+    memset(&strip[0], 0, strip.size());
+}
+
+// === Stream ===
+
+size_t ESC_POS_Emulator::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+// Commands cut off at the end of a write wait in pending for the rest
+size_t ESC_POS_Emulator::write(const uint8_t *buf, size_t len) {
+    if(pending.empty()) {
+        size_t used = decode(buf, len);
+        pending.assign(buf + used, buf + len);
+    } else {
+        pending.insert(pending.end(), buf, buf + len);
+        size_t used = decode(&pending[0], pending.size());
+        pending.erase(pending.begin(), pending.begin() + used);
+    }
+    return len;
+}
+
+int ESC_POS_Emulator::available() {
+    return (int)(replies.size() - replyPos);
+}
+
+int ESC_POS_Emulator::read() {
+    if(replyPos >= replies.size()) return -1;
+    return replies[replyPos++];
+}
+
+int ESC_POS_Emulator::peek() {
+    if(replyPos >= replies.size()) return -1;
+    return replies[replyPos];
+}
+
+// === Page ===
+
+int ESC_POS_Emulator::width() const {
+    return pageWidth;
+}
+
+const std::vector<uint8_t> &ESC_POS_Emulator::page() const {
+    return bits;
+}
+
+size_t ESC_POS_Emulator::unknown() const {
+    return unknownCount;
+}
+
+size_t ESC_POS_Emulator::cuts() const {
+    return cutCount;
+}
+
+bool ESC_POS_Emulator::dot(int dx, int dy) const {
+    if((dx < 0) || (dx >= pageWidth) || (dy < 0) || (dy >= drawn)) return false;
+    return bits[dy * stride + dx / 8] & (0x80 >> (dx & 7));
+}
+
+int ESC_POS_Emulator::height() const {
+    return max(y, drawn);
+}
+
+bool ESC_POS_Emulator::savePBM(const char *path) const {
+    FILE *f = fopen(path, "wb");
+    if(!f) return false;
+    int h = height();
+    fprintf(f, "P4\n%d %d\n", pageWidth, h);
+    size_t n = (size_t)min(h, drawn) * stride;
+    bool ok = fwrite(bits.data(), 1, n, f) == n;
+    for(int r = drawn; ok && (r < h); r++) { // Fed but never drawn on
+        for(int i = 0; i < stride; i++) ok = (fputc(0, f) != EOF);
+    }
+    return (fclose(f) == 0) && ok;
+}
+
+// Make the page at least rows tall
+void ESC_POS_Emulator::grow(int rows) {
+    if(rows > drawn) {
+        bits.resize((size_t)rows * stride);
+        drawn = rows;
+    }
+}
+
+// OR w bytes of src into dst shifted right by shift dots, dropping what
+// falls past the end of dst (dstBytes long).
+static void orShifted(uint8_t *dst, int dstBytes, const uint8_t *src, int w,
+        int shift) {
+    int first = shift / 8, s = shift & 7;
+
+    for(int i = 0; (i < w) && (first + i < dstBytes); i++) {
+        if(!src[i]) continue;
+        dst[first + i] |= src[i] >> s;
+        if(s && (first + i + 1 < dstBytes)) dst[first + i + 1] |= src[i] << (8 - s);
+    }
+}
+
+static void fill(std::vector<uint8_t> &rows, int stride, int width,
+        int x0, int y0, int w, int h, bool invert=false) {
+    for(int r = y0; r < y0 + h; r++) {
+        uint8_t *row = &rows[(size_t)r * stride];
+        for(int c = max(x0, 0); (c < x0 + w) && (c < width); c++) {
+            if(invert) row[c / 8] ^= 0x80 >> (c & 7);
+            else       row[c / 8] |= 0x80 >> (c & 7);
+        }
+    }
+}
+
+// Where a line or image lineWidth dots wide starts, by ESC a and GS L
+int ESC_POS_Emulator::lineStart(int lineWidth) {
+    int room = pageWidth - margin - lineWidth;
+    if(room < 0) room = 0;
+    return margin + ((justify == 1) ? room / 2 : (justify == 2) ? room : 0);
+}
+
+// Print the line buffer at the top of the line and move the paper on by
+// advance dots.
+void ESC_POS_Emulator::endLine(int advance) {
+    if(lineUsed) {
+        int start = lineStart(lineRight);
+        int top   = STRIP_HEIGHT - lineHeight;
+        grow(y + lineHeight);
+        for(int r = 0; r < lineHeight; r++) {
+            uint8_t *src = &strip[(size_t)(top + r) * stride];
+            orShifted(&bits[(size_t)(y + r) * stride], stride, src,
+                    (lineRight + 7) / 8, start);
+            memset(src, 0, stride);
+        }
+    }
+    y         += advance;
+    x          = 0;
+    lineHeight = 0;
+    lineRight  = 0;
+    lineUsed   = false;
+}
+
+int ESC_POS_Emulator::lineAdvance() {
+    int spacing = (lineSpacing < 0) ? DEFAULT_SPACING : lineSpacing;
+    return max(spacing, lineHeight);
+}
+
+void ESC_POS_Emulator::flushLine() {
+    if(lineUsed) endLine(lineAdvance());
+}
+
+// Something w dots wide and h high was put on the line at x
+void ESC_POS_Emulator::used(int w, int h) {
+    x         += w;
+    lineRight  = max(lineRight, min(x, pageWidth - margin));
+    lineHeight = max(lineHeight, min(h, STRIP_HEIGHT));
+    lineUsed   = true;
+}
+
+// === Text ===
+
+int ESC_POS_Emulator::cellWidth() {
+    return ((fontB ? 9 : 12) + charSpacing) * widthMul;
+}
+
+int ESC_POS_Emulator::cellHeight() {
+    return (fontB ? 17 : 24) * heightMul;
+}
+
+void ESC_POS_Emulator::text(uint8_t c) {
+    int w = cellWidth(), h = cellHeight();
+    int gw = (fontB ? 9 : 12) * widthMul; // Without the spacing
+
+    if(x + w > pageWidth - margin) flushLine(); // Wrap
+    if(x + w > pageWidth - margin) return;      // Wider than the page
+
+    int top = STRIP_HEIGHT - min(h, STRIP_HEIGHT);
+    std::map<uint8_t, Image>::const_iterator user = userGlyphs.find(c);
+
+    for(int pass = 0; pass < ((bold || strike) ? 2 : 1); pass++) {
+        int left = x + pass; // Emphasis: drawn again a dot to the right
+        if(userChars && (user != userGlyphs.end())) {
+            // Columns of 3 bytes, top byte first
+            const Image &g = user->second;
+            for(int col = 0; col < g.w; col++) {
+                for(int row = 0; row < g.h; row++) {
+                    if(g.rows[col * (g.h / 8) + row / 8] & (0x80 >> (row & 7))) {
+                        fill(strip, stride, pageWidth, left + col * widthMul,
+                                top + row * heightMul, widthMul, heightMul);
+                    }
+                }
+            }
+        } else if((c > ' ') && (c < 0x7F)) {
+            // Font dots 2 x 3 (font A) or 1 x 2 (font B) printer dots
+            int dw = fontB ? 1 : 2, dh = fontB ? 2 : 3;
+            int ox = fontB ? 2 : 1, oy = fontB ? 2 : 1;
+            for(int col = 0; col < 5; col++) {
+                uint8_t bitsCol = font[c - ' '][col];
+                for(int row = 0; row < 7; row++) {
+                    if(bitsCol & (1 << row)) {
+                        fill(strip, stride, pageWidth,
+                                left + (ox + col * dw) * widthMul,
+                                top + (oy + row * dh) * heightMul,
+                                dw * widthMul, dh * heightMul);
+                    }
+                }
+            }
+        } else if(c >= 0x80) {
+            // Code page character: a box
+            int bx = left + 2 * widthMul, by = top + 3 * heightMul;
+            int bw = gw - 4 * widthMul,   bh = h - 6 * heightMul;
+            fill(strip, stride, pageWidth, bx, by, bw, heightMul);
+            fill(strip, stride, pageWidth, bx, by + bh - heightMul, bw, heightMul);
+            fill(strip, stride, pageWidth, bx, by, widthMul, bh);
+            fill(strip, stride, pageWidth, bx + bw - widthMul, by, widthMul, bh);
+        }
+    }
+    if(underline) {
+        fill(strip, stride, pageWidth, x, STRIP_HEIGHT - underline, w, underline);
+    }
+    if(inverse) fill(strip, stride, pageWidth, x, top, w, h, true);
+    used(w, h);
+}
+
+// === Graphics ===
+
+// ESC * band: w columns of bandBytes bytes, top byte first
+void ESC_POS_Emulator::bandImage(const uint8_t *cols, int w, int bandBytes,
+        int xScale, int yScale) {
+    int h = bandBytes * 8 * yScale, top = STRIP_HEIGHT - h;
+
+    for(int col = 0; col < w; col++, cols += bandBytes) {
+        for(int row = 0; row < bandBytes * 8; row++) {
+            if(cols[row / 8] & (0x80 >> (row & 7))) {
+                fill(strip, stride, pageWidth, x + col * xScale,
+                        top + row * yScale, xScale, yScale);
+            }
+        }
+    }
+    used(w * xScale, h);
+}
+
+// Print row-major rows, rowBytes per row, at the top of a new line
+void ESC_POS_Emulator::blit(const uint8_t *rows, int w, int h, int rowBytes,
+        int xScale, int yScale, bool justified) {
+    flushLine();
+    int start = justified ? lineStart(w * xScale) : margin;
+
+    grow(y + h * yScale);
+    for(int r = 0; r < h; r++, rows += rowBytes) {
+        if(xScale == 1) {
+            for(int k = 0; k < yScale; k++) {
+                orShifted(&bits[(size_t)(y + r * yScale + k) * stride],
+                        stride, rows, (w + 7) / 8, start);
+            }
+            continue;
+        }
+        for(int c = 0; c < w; c++) {
+            if(rows[c / 8] & (0x80 >> (c & 7))) {
+                fill(bits, stride, pageWidth, start + c * xScale,
+                        y + r * yScale, xScale, yScale);
+            }
+        }
+    }
+    y += h * yScale;
+}
+
+void ESC_POS_Emulator::printStored(uint16_t key, int xScale, int yScale) {
+    std::map<uint16_t, Image>::const_iterator i = stored.find(key);
+    if(i == stored.end()) return;
+    const Image &g = i->second;
+    blit(g.rows.data(), g.w, g.h, (g.w + 7) / 8, xScale, yScale, true);
+}
+
+// Bars for each data byte, most significant bit first, between guard
+// bars, with the human readable text above and/or below.
+void ESC_POS_Emulator::barcode(uint8_t type, const uint8_t *data, size_t len) {
+    std::vector<uint8_t> hri;
+    uint8_t set = 'B';
+
+    for(size_t i = 0; i < len; i++) {
+        uint8_t c = data[i];
+        if((type == 73) && (c == '{') && (i + 1 < len)) { // Code 128 codes
+            c = data[++i];
+            if((c >= 'A') && (c <= 'C')) set = c;
+            if(c != '{') continue;
+        } else if((type == 73) && (set == 'C')) {
+            hri.push_back('0' + c / 10 % 10);
+            c = '0' + c % 10;
+        }
+        hri.push_back(c);
+    }
+
+    int modules = (int)len * 8 + 4;
+    int w       = modules * barcodeWidth;
+    std::vector<uint8_t> row((modules * barcodeWidth + 7) / 8);
+    for(int m = 0; m < modules; m++) {
+        bool bar = (m == 0) || (m == modules - 2) ||
+                   ((m >= 2) && (m < modules - 2) &&
+                    (data[(m - 2) / 8] & (0x80 >> ((m - 2) & 7))));
+        if(bar) {
+            for(int d = m * barcodeWidth; d < (m + 1) * barcodeWidth; d++) {
+                row[d / 8] |= 0x80 >> (d & 7);
+            }
+        }
+    }
+
+    if(barcodeText & 1) hriLine(hri, w);
+    flushLine();
+    int start = lineStart(w);
+    grow(y + barcodeHeight);
+    for(int r = 0; r < barcodeHeight; r++) {
+        orShifted(&bits[(size_t)(y + r) * stride], stride, row.data(),
+                (int)row.size(), start);
+    }
+    y += barcodeHeight;
+    if(barcodeText & 2) hriLine(hri, w);
+}
+
+// A line of barcode text in font A, centred under a barcode w dots wide
+void ESC_POS_Emulator::hriLine(const std::vector<uint8_t> &hri, int w) {
+    bool savedFontB = fontB, savedBold = bold, savedStrike = strike,
+         savedInverse = inverse;
+    int savedWidth = widthMul, savedHeight = heightMul,
+        savedUnderline = underline, savedSpacing = charSpacing,
+        savedJustify = justify;
+
+    flushLine();
+    fontB = bold = strike = inverse = false;
+    widthMul = heightMul = 1;
+    underline = charSpacing = 0;
+    int textWidth = (int)hri.size() * 12;
+    x = max(0, lineStart(w) - margin + (w - textWidth) / 2);
+    justify = 0;
+    for(size_t i = 0; i < hri.size(); i++) text(hri[i]);
+    endLine(24);
+
+    fontB = savedFontB; bold = savedBold; strike = savedStrike;
+    inverse = savedInverse; widthMul = savedWidth; heightMul = savedHeight;
+    underline = savedUnderline; charSpacing = savedSpacing;
+    justify = savedJustify;
+}
+
+void ESC_POS_Emulator::qrCode() {
+    ESC_POS_QRCode qr;
+    if(!qr.encode(qrData.data(), qrData.size(), qrEc)) return;
+    int size = qr.size();
+    std::vector<uint8_t> rows((size_t)size * ((size + 7) / 8));
+    for(int r = 0; r < size; r++) {
+        for(int c = 0; c < size; c++) {
+            if(qr.module(c, r)) rows[r * ((size + 7) / 8) + c / 8] |= 0x80 >> (c & 7);
+        }
+    }
+    blit(rows.data(), size, size, (size + 7) / 8, qrModule, qrModule, true);
+}
+
+// === Commands ===
+
+size_t ESC_POS_Emulator::decode(const uint8_t *buf, size_t len) {
+    size_t i = 0;
+    while(i < len) {
+        size_t n = command(buf + i, len - i);
+        if(!n) break; // Cut off; wait for more
+        i += n;
+    }
+    return i;
+}
+
+// Carry out the command or character at p.  Returns the bytes it takes,
+// or 0 if they are not all there yet.
+size_t ESC_POS_Emulator::command(const uint8_t *p, size_t len) {
+    uint8_t c = p[0];
+
+    if((c >= ' ') && (c != 0x7F)) {
+        text(c);
+        return 1;
+    }
+    switch(c) {
+        case ASCII_LF:
+            endLine(lineAdvance());
+            return 1;
+
+        case ASCII_HT: {
+            int cell = 12 + charSpacing, stop = -1;
+            int column = (x + cell - 1) / cell;
+            if(tabCount == TABS_DEFAULT) {
+                stop = (column / 8 + 1) * 8;
+            } else {
+                for(uint8_t i = 0; i < tabCount; i++) {
+                    if(tabs[i] * cell > x) {
+                        stop = tabs[i];
+                        break;
+                    }
+                }
+            }
+            if((stop >= 0) && (stop * cell <= pageWidth - margin)) {
+                x = stop * cell;
+                lineRight = max(lineRight, x);
+            }
+            return 1;
+        }
+
+        case ASCII_DLE:
+            NEED(3);
+            if(p[1] == ASCII_EOT) {
+                replies.push_back(0x12); // Online, no errors, paper
+                return 3;
+            }
+            if(p[1] == ASCII_DC4) {
+                NEED(5);
+                return (p[2] == 8) ? 10 : 5; // Clear buffers is longer
+            }
+            return 3; // DLE ENQ n and others
+
+        case ASCII_DC2: // DC2 * r n data: r rows of n bytes
+            NEED(4);
+            if(p[1] != '*') return 2;
+            NEED(4 + p[2] * p[3]);
+            blit(p + 4, p[3] * 8, p[2], p[3], 1, 1, false);
+            return 4 + p[2] * p[3];
+
+        case ASCII_FS:
+            NEED(2);
+            if(p[1] == 'p') {
+                NEED(4);
+                return 4;
+            }
+            if(p[1] == 'q') { // NV bit images, not drawn
+                NEED(3);
+                size_t n = 3;
+                for(uint8_t i = 0; i < p[2]; i++) {
+                    NEED(n + 4);
+                    n += 4 + (size_t)(p[n] | (p[n + 1] << 8)) *
+                             (p[n + 2] | (p[n + 3] << 8)) * 8;
+                }
+                NEED(n);
+                return n;
+            }
+            return 2;
+
+        case ASCII_ESC:
+            NEED(2);
+            return escCommand(p, len);
+
+        case ASCII_GS:
+            NEED(2);
+            return gsCommand(p, len);
+    }
+    return 1; // CR and other control characters
+}
+
+size_t ESC_POS_Emulator::escCommand(const uint8_t *p, size_t len) {
+    switch(p[1]) {
+        case '@':
+            reset();
+            return 2;
+        case '2':
+            lineSpacing = -1;
+            return 2;
+        case ' ': NEED(3); charSpacing = p[2];               return 3;
+        case '!': NEED(3);
+            fontB     = p[2] & 0x01;
+            bold      = p[2] & 0x08;
+            heightMul = (p[2] & 0x10) ? 2 : 1;
+            widthMul  = (p[2] & 0x20) ? 2 : 1;
+            underline = (p[2] & 0x80) ? 1 : 0;
+            return 3;
+        case '-': NEED(3); underline = (p[2] & 3) % 3;     return 3;
+        case '3': NEED(3); lineSpacing = p[2];             return 3;
+        case 'E': NEED(3); bold   = p[2] & 1;              return 3;
+        case 'G': NEED(3); strike = p[2] & 1;              return 3;
+        case 'M': NEED(3); fontB  = p[2] & 1;              return 3;
+        case 'a': NEED(3); justify = (p[2] & 3) % 3;       return 3;
+        case '%': NEED(3); userChars = p[2] & 1;           return 3;
+        case '?': NEED(3); userGlyphs.erase(p[2]);         return 3;
+        case '=': case 'R': case 't': case 'U': case '{': case 'V':
+        case 'T': case 'c': case 'r':
+            NEED(3);
+            if(p[1] == 'c') {
+                NEED(4);
+                return 4;
+            }
+            return 3;
+        case '$': NEED(4);
+            x = min(p[2] | (p[3] << 8), pageWidth - margin);
+            lineRight = max(lineRight, x);
+            return 4;
+        case '\\': NEED(4);
+            x = constrain(x + (int16_t)(p[2] | (p[3] << 8)), 0, pageWidth - margin);
+            lineRight = max(lineRight, x);
+            return 4;
+        case '8': NEED(4);                                 return 4;
+        case 'p': NEED(5);                                 return 5;
+        case 'd': NEED(3);
+            endLine(p[2] ? lineAdvance() : lineHeight);
+            for(int i = 1; i < p[2]; i++) {
+                y += (lineSpacing < 0) ? DEFAULT_SPACING : lineSpacing;
+            }
+            return 3;
+        case 'J': NEED(3);
+            endLine(lineUsed ? max((int)p[2], lineHeight) : p[2]);
+            return 3;
+        case 'D': {
+            size_t n = 2;
+            tabCount = 0;
+            for(;;) {
+                NEED(n + 1);
+                if(!p[n]) break;
+                if(tabCount < sizeof(tabs)) tabs[tabCount++] = p[n];
+                n++;
+            }
+            return n + 1;
+        }
+        case '*': {
+            NEED(5);
+            int m = p[2], w = p[3] | (p[4] << 8);
+            int bandBytes = (m & 32) ? 3 : 1;
+            NEED(5 + w * bandBytes);
+            bandImage(p + 5, w, bandBytes, (m & 1) ? 1 : 2, (m & 32) ? 1 : 2);
+            return 5 + w * bandBytes;
+        }
+        case '&': { // ESC & y c1 c2 [x d1 ... d(y * x)] ...
+            NEED(5);
+            size_t n = 5;
+            uint8_t h = p[2];
+            for(int code = p[3]; code <= p[4]; code++) {
+                NEED(n + 1);
+                size_t k = (size_t)h * p[n];
+                NEED(n + 1 + k);
+                Image &g = userGlyphs[code];
+                g.w = p[n];
+                g.h = h * 8;
+                g.rows.assign(p + n + 1, p + n + 1 + k);
+                n += 1 + k;
+            }
+            return n;
+        }
+    }
+    unknownCount++;
+    return 2;
+}
+
+size_t ESC_POS_Emulator::gsCommand(const uint8_t *p, size_t len) {
+    switch(p[1]) {
+        case '!': NEED(3);
+            widthMul  = ((p[2] >> 4) & 7) + 1;
+            heightMul = (p[2] & 7) + 1;
+            return 3;
+        case 'B': NEED(3); inverse = p[2] & 1;             return 3;
+        case 'H': NEED(3); barcodeText = p[2] & 3;         return 3;
+        case 'h': NEED(3); barcodeHeight = max((int)p[2], 1); return 3;
+        case 'w': NEED(3); barcodeWidth = constrain((int)p[2], 1, 6); return 3;
+        case 'a': case 'f': case 'r': case 'I':
+            NEED(3);
+            return 3;
+        case 'L': NEED(4);
+            margin = min(p[2] | (p[3] << 8), pageWidth - 8);
+            return 4;
+        case 'W': case 'P': NEED(4);                       return 4;
+        case 'V': NEED(3);
+            flushLine();
+            cutCount++;
+            if((p[2] == 65) || (p[2] == 66)) {
+                NEED(4);
+                return 4;
+            }
+            return 3;
+        case 'v': { // GS v 0 m xL xH yL yH: y rows of x bytes
+            NEED(8);
+            if(p[2] != '0') break;
+            int w = p[4] | (p[5] << 8), h = p[6] | (p[7] << 8);
+            NEED(8 + (size_t)w * h);
+            blit(p + 8, w * 8, h, w, (p[3] & 1) ? 2 : 1, (p[3] & 2) ? 2 : 1, true);
+            return 8 + (size_t)w * h;
+        }
+        case '/': NEED(3);
+            printStored(0, (p[2] & 1) ? 2 : 1, (p[2] & 2) ? 2 : 1);
+            return 3;
+        case '*': { // GS * x y: x * 8 columns of y bytes, top byte first
+            NEED(4);
+            int w = p[2] * 8, hb = p[3];
+            NEED(4 + w * hb);
+            Image &g = stored[0];
+            g.w = w;
+            g.h = hb * 8;
+            g.rows.assign((size_t)p[2] * g.h, 0);
+            for(int col = 0; col < w; col++) {
+                for(int row = 0; row < g.h; row++) {
+                    if(p[4 + col * hb + row / 8] & (0x80 >> (row & 7))) {
+                        g.rows[row * p[2] + col / 8] |= 0x80 >> (col & 7);
+                    }
+                }
+            }
+            return 4 + w * hb;
+        }
+        case 'k': {
+            NEED(3);
+            uint8_t m = p[2];
+            if(m <= 6) { // Function A, NUL terminated
+                size_t n = 3;
+                for(;;) {
+                    NEED(n + 1);
+                    if(!p[n]) break;
+                    n++;
+                }
+                barcode(m + 65, p + 3, n - 3);
+                return n + 1;
+            }
+            NEED(4);
+            NEED(4 + p[3]);
+            barcode(m, p + 4, p[3]);
+            return 4 + p[3];
+        }
+        case '(': case '8': {
+            // GS ( X pL pH, or GS 8 L p1 p2 p3 p4, then p bytes
+            size_t head = (p[1] == '8') ? 7 : 5;
+            NEED(head);
+            size_t n = p[3] | (p[4] << 8);
+            if(head == 7) n |= ((size_t)p[5] << 16) | ((size_t)p[6] << 24);
+            NEED(head + n);
+            if(p[2] == 'L') graphics(p + head, n);
+            else if(p[2] == 'k') qrCommand(p + head, n);
+            return head + n;
+        }
+    }
+    unknownCount++;
+    return 2;
+}
+
+// GS ( L / GS 8 L graphics functions, from m on
+void ESC_POS_Emulator::graphics(const uint8_t *q, size_t n) {
+    if(n < 2) return;
+    switch(q[1]) {
+        case 67: case 83: { // Define NV / downloaded graphics, raster
+            if(n < 11) return;
+            Image &g = stored[(q[3] << 8) | q[4]];
+            g.w = q[6] | (q[7] << 8);
+            g.h = q[8] | (q[9] << 8);
+            size_t k = (size_t)((g.w + 7) / 8) * g.h;
+            if(n < 11 + k) k = n - 11;
+            g.rows.assign(q + 11, q + 11 + k);
+            g.rows.resize((size_t)((g.w + 7) / 8) * g.h);
+            break;
+        }
+        case 69: case 85: // Print NV / downloaded graphics
+            if(n < 6) return;
+            printStored((q[2] << 8) | q[3], q[4], q[5]);
+            break;
+        case 66: case 82: // Delete
+            if(n < 4) return;
+            stored.erase((q[2] << 8) | q[3]);
+            break;
+    }
+}
+
+// GS ( k QR code functions, from cn on
+void ESC_POS_Emulator::qrCommand(const uint8_t *q, size_t n) {
+    if((n < 2) || (q[0] != 49)) return;
+    switch(q[1]) {
+        case 67: if(n >= 3) qrModule = constrain((int)q[2], 1, 16);  break;
+        case 69: if(n >= 3) qrEc = "LMQH"[(q[2] - 48) & 3];         break;
+        case 80: if(n >= 3) qrData.assign(q + 3, q + n);            break;
+        case 81: qrCode();                                          break;
+    }
+}
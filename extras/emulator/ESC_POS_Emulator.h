@@ -0,0 +1,148 @@
+/*------------------------------------------------------------------------
+  ESC/POS emulator for host tests of ESC_POS_Printer.
+
+  A Stream that decodes the commands the library sends and draws what a
+  printer would print on an in-memory page, 1 bit per dot, which can be
+  compared with an expected image or saved as a PBM file.  Text, styles,
+  sizes, justification, tabs and positions, ESC * / DC2 * / GS v 0
+  images, stored images, user-defined characters and QR codes are drawn
+  as the printer would, give or take the font: characters are a 5 x 7
+  font scaled to the 12 x 24 (font A) or 9 x 17 (font B) cell, and code
+  page characters are boxes.  Barcodes are drawn as bars of their data
+  bytes, not the real symbology, so only their placement and content
+  are checked.  DLE EOT requests are answered with "all well".
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_EMULATOR_H
+#define ESC_POS_EMULATOR_H
+
+#include "Arduino.h"
+#include "ESC_POS_Profile.h"
+
+#include <map>
+#include <vector>
+
+class ESC_POS_Emulator : public Stream {
+
+    public:
+
+        ESC_POS_Emulator(int width=ESC_POS_PROFILE.dots);
+
+        size_t
+            write(uint8_t c),
+            write(const uint8_t *buf, size_t len);
+        using Print::write;
+        int
+            available(),
+            read(),
+            peek();
+
+        // Forget everything printed and reset the printer state
+        void
+            clear();
+        // Print what is waiting in the line buffer, as the printer would
+        // on a feed.  Call before looking at the page.
+        void
+            flushLine();
+
+        int
+            width() const,
+            height() const;  // Rows fed or drawn on so far
+        bool
+            dot(int x, int y) const;
+        // Rows of width() / 8 bytes, most significant bit leftmost.  Rows
+        // fed past the last one drawn on are left out.
+        const std::vector<uint8_t> &
+            page() const;
+
+        size_t
+            unknown() const, // Commands not known, skipped as two bytes
+            cuts() const;
+
+        // Write the page (height() rows) as a binary PBM image
+        bool
+            savePBM(const char *path) const;
+
+    private:
+
+        struct Image {
+            int w, h;              // Dots
+            std::vector<uint8_t> rows; // Row-major, or columns for ESC &
+        };
+
+        int
+            pageWidth,
+            stride,                // Bytes per page row
+            y,                     // Top of the line being printed
+            drawn,                 // Rows of the page drawn on
+            x,                     // Next dot on the line, from the margin
+            lineHeight,            // Tallest thing on the line so far
+            lineRight,             // Rightmost dot used on the line
+            margin,                // GS L left margin
+            lineSpacing,           // ESC 3, or -1 for ESC 2 default
+            charSpacing,
+            justify,               // 0 left, 1 centre, 2 right
+            widthMul,
+            heightMul,
+            underline,             // Dots
+            barcodeHeight,
+            barcodeWidth,
+            barcodeText,
+            qrModule;
+        char
+            qrEc;
+        uint8_t
+            tabs[32],
+            tabCount;
+        bool
+            fontB,
+            bold,
+            strike,
+            inverse,
+            userChars,             // ESC % 1
+            lineUsed;
+        std::vector<uint8_t>
+            bits,                  // The page
+            strip,                 // The line being built, bottom aligned
+            pending,               // Start of a command cut off by a write
+            replies,
+            qrData;
+        size_t
+            replyPos,
+            unknownCount,
+            cutCount;
+        std::map<uint16_t, Image>
+            stored;                // GS ( L images by key code, 0 = GS *
+        std::map<uint8_t, Image>
+            userGlyphs;            // ESC & characters
+
+        void
+            reset(),
+            grow(int rows),
+            endLine(int advance),
+            used(int w, int h),
+            text(uint8_t c),
+            bandImage(const uint8_t *cols, int w, int bandBytes, int xScale,
+                    int yScale),
+            blit(const uint8_t *rows, int w, int h, int rowBytes, int xScale,
+                    int yScale, bool justified),
+            printStored(uint16_t key, int xScale, int yScale),
+            barcode(uint8_t type, const uint8_t *data, size_t len),
+            hriLine(const std::vector<uint8_t> &hri, int w),
+            qrCode(),
+            graphics(const uint8_t *q, size_t n),
+            qrCommand(const uint8_t *q, size_t n);
+        size_t
+            decode(const uint8_t *buf, size_t len),
+            command(const uint8_t *p, size_t len),
+            escCommand(const uint8_t *p, size_t len),
+            gsCommand(const uint8_t *p, size_t len);
+        int
+            cellWidth(),
+            cellHeight(),
+            lineAdvance(),
+            lineStart(int lineWidth);
+};
+
+#endif // ESC_POS_EMULATOR_H
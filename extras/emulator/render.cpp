@@ -0,0 +1,40 @@
+/*------------------------------------------------------------------------
+  Draw a file of ESC/POS bytes as a PBM image.
+
+      esc_pos_render output.bin page.pbm [width]
+
+  width is the printable width in dots, by default that of the profile.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Emulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv) {
+    if((argc < 3) || (argc > 4)) {
+        fprintf(stderr, "usage: %s input.bin output.pbm [width]\n", argv[0]);
+        return 2;
+    }
+    FILE *in = fopen(argv[1], "rb");
+    if(!in) {
+        perror(argv[1]);
+        return 1;
+    }
+    ESC_POS_Emulator printer((argc == 4) ? atoi(argv[3]) : ESC_POS_PROFILE.dots);
+    uint8_t buf[4096];
+    size_t n;
+    while((n = fread(buf, 1, sizeof(buf), in)) > 0) printer.write(buf, n);
+    fclose(in);
+
+    printer.flushLine();
+    if(!printer.savePBM(argv[2])) {
+        perror(argv[2]);
+        return 1;
+    }
+    if(printer.unknown()) {
+        fprintf(stderr, "%u unknown commands\n", (unsigned)printer.unknown());
+    }
+    return 0;
+}
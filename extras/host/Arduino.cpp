@@ -0,0 +1,219 @@
+/*------------------------------------------------------------------------
+  Host implementation of the Arduino core subset in Arduino.h.
+  ------------------------------------------------------------------------*/
+
+#include "Arduino.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+HostSerial Serial;
+
+static uint64_t nowMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000u;
+}
+
+static const uint64_t startMicros = nowMicros();
+
+unsigned long millis(void) {
+    return (unsigned long)((nowMicros() - startMicros) / 1000u);
+}
+
+unsigned long micros(void) {
+    return (unsigned long)(nowMicros() - startMicros);
+}
+
+void delay(unsigned long ms) {
+    usleep(ms * 1000u);
+}
+
+void delayMicroseconds(unsigned int us) {
+    usleep(us);
+}
+
+void yield(void) {
+}
+
+// There are no pins on the host.  Inputs read HIGH, like a pulled up pin.
+void pinMode(uint8_t, uint8_t) {
+}
+
+void digitalWrite(uint8_t, uint8_t) {
+}
+
+int digitalRead(uint8_t) {
+    return HIGH;
+}
+
+// === Print ===
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while(size--) {
+        if(write(*buffer++)) n++;
+        else break;
+    }
+    return n;
+}
+
+size_t Print::print(const __FlashStringHelper *s) {
+    return write(reinterpret_cast<const char *>(s));
+}
+
+size_t Print::print(const char s[]) {
+    return write(s);
+}
+
+size_t Print::print(char c) {
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char b, int base) {
+    return print((unsigned long)b, base);
+}
+
+size_t Print::print(int n, int base) {
+    return print((long)n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(long n, int base) {
+    if(base == 0) return write((uint8_t)n);
+    if(base == 10 && n < 0) {
+        size_t t = print('-');
+        return printNumber(-(unsigned long)n, 10) + t;
+    }
+    return printNumber(n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+    if(base == 0) return write((uint8_t)n);
+    return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+    return printFloat(n, digits);
+}
+
+size_t Print::println(void) {
+    return write("\r\n");
+}
+
+size_t Print::println(const __FlashStringHelper *s) {
+    size_t n = print(s);
+    return n + println();
+}
+
+size_t Print::println(const char c[]) {
+    size_t n = print(c);
+    return n + println();
+}
+
+size_t Print::println(char c) {
+    size_t n = print(c);
+    return n + println();
+}
+
+size_t Print::println(unsigned char b, int base) {
+    size_t n = print(b, base);
+    return n + println();
+}
+
+size_t Print::println(int num, int base) {
+    size_t n = print(num, base);
+    return n + println();
+}
+
+size_t Print::println(unsigned int num, int base) {
+    size_t n = print(num, base);
+    return n + println();
+}
+
+size_t Print::println(long num, int base) {
+    size_t n = print(num, base);
+    return n + println();
+}
+
+size_t Print::println(unsigned long num, int base) {
+    size_t n = print(num, base);
+    return n + println();
+}
+
+size_t Print::println(double num, int digits) {
+    size_t n = print(num, digits);
+    return n + println();
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    *str = '\0';
+    if(base < 2) base = 10;
+    do {
+        char c = n % base;
+        n /= base;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while(n);
+
+    return write(str);
+}
+
+size_t Print::printFloat(double number, uint8_t digits) {
+    char buf[48];
+    if(isnan(number)) return print("nan");
+    if(isinf(number)) return print("inf");
+    snprintf(buf, sizeof(buf), "%.*f", digits, number);
+    return write(buf);
+}
+
+// === Stream ===
+
+int Stream::timedRead() {
+    unsigned long start = millis();
+    do {
+        int c = read();
+        if(c >= 0) return c;
+        yield();
+    } while(millis() - start < _timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+    size_t count = 0;
+    while(count < length) {
+        int c = timedRead();
+        if(c < 0) break;
+        *buffer++ = (char)c;
+        count++;
+    }
+    return count;
+}
+
+// === Serial ===
+
+size_t HostSerial::write(uint8_t c) {
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HostSerial::write(const uint8_t *buf, size_t len) {
+    return fwrite(buf, 1, len, stdout);
+}
+
+int HostSerial::available() {
+    return 0;
+}
+
+int HostSerial::read() {
+    return -1;
+}
+
+int HostSerial::peek() {
+    return -1;
+}
@@ -0,0 +1,88 @@
+/*------------------------------------------------------------------------
+  Minimal Arduino core for building ESC_POS_Printer on a Linux host.
+
+  Only what the library and its host tools use is provided: the Print and
+  Stream classes, PROGMEM accessors and the timing functions.
+  ------------------------------------------------------------------------*/
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include <type_traits>
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW  0
+#define INPUT  0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define DEC 10
+#define HEX 16
+#define OCT  8
+#define BIN  2
+
+// Flash and RAM share one address space on the host
+#define PROGMEM
+#define PSTR(s) (s)
+typedef const char *PGM_P;
+#define pgm_read_byte(addr)  (*(const uint8_t  *)(addr))
+#define pgm_read_word(addr)  (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+template<class A, class B>
+inline typename std::common_type<A, B>::type min(A a, B b) {
+    return (a < b) ? a : b;
+}
+template<class A, class B>
+inline typename std::common_type<A, B>::type max(A a, B b) {
+    return (a > b) ? a : b;
+}
+template<class T, class L, class H>
+inline T constrain(T x, L low, H high) {
+    return (x < low) ? low : (x > high) ? high : x;
+}
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+
+#include "Print.h"
+#include "Stream.h"
+
+// Serial writes to stdout and reads from stdin
+class HostSerial : public Stream {
+    public:
+        void begin(unsigned long) {}
+        size_t write(uint8_t c);
+        size_t write(const uint8_t *buf, size_t len);
+        int available();
+        int read();
+        int peek();
+        operator bool() { return true; }
+        using Print::write;
+};
+
+extern HostSerial Serial;
+
+#endif // ARDUINO_H
@@ -0,0 +1,239 @@
+/*------------------------------------------------------------------------
+  A Stream on a POSIX file descriptor, for driving printers from Linux.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_FdStream.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+ESC_POS_FdStream::ESC_POS_FdStream(int fd) :
+    handle(fd), owned(false), socket(false), rxPos(0), rxLen(0) {
+    struct stat st;
+    if((fd >= 0) && (fstat(fd, &st) == 0)) socket = S_ISSOCK(st.st_mode);
+}
+
+ESC_POS_FdStream::~ESC_POS_FdStream() {
+    close();
+}
+
+static speed_t baudCode(unsigned long baud) {
+    switch(baud) {
+        case   9600: return B9600;
+        case  19200: return B19200;
+        case  38400: return B38400;
+        case  57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        default:     return B0;
+    }
+}
+
+bool ESC_POS_FdStream::open(const char *path, unsigned long baud,
+        bool nonBlocking) {
+    close();
+    handle = ::open(path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if(handle < 0) handle = ::open(path, O_WRONLY | O_NOCTTY | O_CLOEXEC);
+    if(handle < 0) return false;
+    owned = true;
+
+    if(baud && isatty(handle)) {
+        struct termios tio;
+        speed_t speed = baudCode(baud);
+        if((speed == B0) || (tcgetattr(handle, &tio) != 0)) {
+            close();
+            return false;
+        }
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        if(tcsetattr(handle, TCSANOW, &tio) != 0) {
+            close();
+            return false;
+        }
+    }
+    return setNonBlocking(nonBlocking);
+}
+
+bool ESC_POS_FdStream::connect(const char *host, uint16_t port,
+        bool nonBlocking) {
+    struct addrinfo hints, *found, *a;
+    char service[6];
+
+    close();
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(service, sizeof(service), "%u", port);
+    if(getaddrinfo(host, service, &hints, &found) != 0) return false;
+
+    for(a = found; a; a = a->ai_next) {
+        handle = ::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC,
+                a->ai_protocol);
+        if(handle < 0) continue;
+        if(::connect(handle, a->ai_addr, a->ai_addrlen) == 0) break;
+        ::close(handle);
+        handle = -1;
+    }
+    freeaddrinfo(found);
+    if(handle < 0) return false;
+
+    // Small commands go out at once rather than waiting to fill a packet
+    int on = 1;
+    setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    owned  = true;
+    socket = true;
+    return setNonBlocking(nonBlocking);
+}
+
+bool ESC_POS_FdStream::setNonBlocking(bool on) {
+    int flags = fcntl(handle, F_GETFL);
+    if(flags < 0) return false;
+    flags = on ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(handle, F_SETFL, flags) == 0;
+}
+
+void ESC_POS_FdStream::close() {
+    if(owned && (handle >= 0)) ::close(handle);
+    handle = -1;
+    owned  = false;
+    socket = false;
+    rxPos  = 0;
+    rxLen  = 0;
+}
+
+int ESC_POS_FdStream::fd() {
+    return handle;
+}
+
+// True if the descriptor is ready for events within ms (-1 waits forever)
+bool ESC_POS_FdStream::ready(short events, int ms) {
+    struct pollfd p = { handle, events, 0 };
+    int n;
+
+    do {
+        n = poll(&p, 1, ms);
+    } while((n < 0) && (errno == EINTR));
+    return (n > 0) && (p.revents & (events | POLLHUP | POLLERR));
+}
+
+// === Output ===
+
+size_t ESC_POS_FdStream::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t ESC_POS_FdStream::write(const uint8_t *buf, size_t len) {
+    struct iovec v = { (void *)buf, len };
+    return writev(&v, 1);
+}
+
+size_t ESC_POS_FdStream::writeGather(const uint8_t *a, size_t aLen,
+        const uint8_t *b, size_t bLen) {
+    struct iovec v[2] = { { (void *)a, aLen }, { (void *)b, bLen } };
+    return aLen ? writev(v, 2) : writev(v + 1, 1);
+}
+
+// Write count buffers in as few calls as the descriptor allows,
+// ESC_POS_FD_IOV at most in each.  Returns the bytes written, less than
+// asked if the descriptor failed or stayed full for the stream's timeout.
+size_t ESC_POS_FdStream::writev(const struct iovec *iov, int count) {
+    size_t done = 0;
+
+    while(count > 0) {
+        int    n    = min(count, ESC_POS_FD_IOV);
+        size_t want = 0;
+        for(int i = 0; i < n; i++) want += iov[i].iov_len;
+        size_t sent = writeGroup(iov, n);
+        done += sent;
+        if(sent < want) break;
+        iov   += n;
+        count -= n;
+    }
+    return done;
+}
+
+// One group of up to ESC_POS_FD_IOV buffers, as writev()
+size_t ESC_POS_FdStream::writeGroup(const struct iovec *iov, int count) {
+    struct iovec v[ESC_POS_FD_IOV], *p = v;
+    size_t done = 0;
+
+    memcpy(v, iov, count * sizeof(*iov));
+    while(count > 0) {
+        ssize_t n;
+        if(socket) {
+            struct msghdr m;
+            memset(&m, 0, sizeof(m));
+            m.msg_iov    = p;
+            m.msg_iovlen = count;
+            n = sendmsg(handle, &m, MSG_NOSIGNAL);
+        } else {
+            n = ::writev(handle, p, count);
+        }
+        if(n < 0) {
+            if(errno == EINTR) continue;
+            if(((errno == EAGAIN) || (errno == EWOULDBLOCK)) &&
+                    ready(POLLOUT, (int)_timeout)) continue;
+            setWriteError();
+            break;
+        }
+        done += n;
+        // Step past what went, possibly part way into a buffer
+        while((count > 0) && ((size_t)n >= p->iov_len)) {
+            n -= p->iov_len;
+            p++;
+            count--;
+        }
+        if(count > 0) {
+            p->iov_base = (uint8_t *)p->iov_base + n;
+            p->iov_len -= n;
+        }
+    }
+    return done;
+}
+
+int ESC_POS_FdStream::availableForWrite() {
+    return ready(POLLOUT, 0) ? ESC_POS_FD_WRITE_CHUNK : 0;
+}
+
+// === Input ===
+
+// Read whatever has arrived, without waiting
+bool ESC_POS_FdStream::fill() {
+    if(rxPos < rxLen) return true;
+    rxPos = rxLen = 0;
+    if(!ready(POLLIN, 0)) return false;
+    ssize_t n = ::read(handle, rx, sizeof(rx));
+    if(n <= 0) return false;
+    rxLen = n;
+    return true;
+}
+
+bool ESC_POS_FdStream::waitReadable(unsigned long ms) {
+    return (rxPos < rxLen) || ready(POLLIN, (int)ms);
+}
+
+int ESC_POS_FdStream::available() {
+    fill();
+    return rxLen - rxPos;
+}
+
+int ESC_POS_FdStream::read() {
+    return fill() ? rx[rxPos++] : -1;
+}
+
+int ESC_POS_FdStream::peek() {
+    return fill() ? rx[rxPos] : -1;
+}
@@ -0,0 +1,86 @@
+/*------------------------------------------------------------------------
+  A Stream on a POSIX file descriptor, for driving printers from Linux.
+
+  ESC_POS_FdStream talks to a USB printer (/dev/usb/lp0), a serial port
+  (/dev/ttyUSB0), a pipe, a file or a TCP socket (port 9100).  Writes are
+  whole: with a non-blocking descriptor they wait in poll() for room, up
+  to the stream's timeout.  Reads never block, so the printer's status
+  path (available(), read()) only takes what poll() says has arrived,
+  and availableForWrite() lets the print queue write only when the
+  descriptor is ready.  Several buffers go out in one writev(); given to
+  ESC_POS_Printer::setGather(), commands and bitmap data are sent
+  together without being copied into one buffer.
+  MIT license, all text above must be included in any redistribution.
+  ------------------------------------------------------------------------*/
+
+#ifndef ESC_POS_FD_STREAM_H
+#define ESC_POS_FD_STREAM_H
+
+#include "Arduino.h"
+#include "ESC_POS_Printer.h"
+
+#include <sys/uio.h>
+
+// Bytes availableForWrite() reports while the descriptor can take more
+#ifndef ESC_POS_FD_WRITE_CHUNK
+#define ESC_POS_FD_WRITE_CHUNK 512
+#endif
+
+// Most buffers in one writev() system call
+#define ESC_POS_FD_IOV 8
+
+class ESC_POS_FdStream : public Stream, public ESC_POS_Gather {
+
+    public:
+
+        // Use fd as it is, without closing it when done
+        ESC_POS_FdStream(int fd=-1);
+        ~ESC_POS_FdStream();
+
+        // Open a device or FIFO, read-write if it allows.  A nonzero baud
+        // sets a serial port to raw 8N1 at that rate.  For a file, open
+        // it as needed and pass the descriptor to the constructor.
+        bool
+            open(const char *path, unsigned long baud=0, bool nonBlocking=false),
+            // Connect to a printer's raw TCP port
+            connect(const char *host, uint16_t port=9100, bool nonBlocking=false),
+            setNonBlocking(bool on=true),
+            // Wait up to ms for something to read
+            waitReadable(unsigned long ms);
+        void
+            close();
+        int
+            fd();
+
+        size_t
+            write(uint8_t c),
+            write(const uint8_t *buf, size_t len),
+            writev(const struct iovec *iov, int count),
+            writeGather(const uint8_t *a, size_t aLen,
+                    const uint8_t *b, size_t bLen);
+        using Print::write;
+        int
+            availableForWrite(),
+            available(),
+            read(),
+            peek();
+
+    private:
+
+        int
+            handle;
+        bool
+            owned,         // Opened here, so closed here
+            socket;        // Written with sendmsg() to avoid SIGPIPE
+        uint8_t
+            rx[64],        // Bytes read ahead for available() and peek()
+            rxPos,
+            rxLen;
+        bool
+            ready(short events, int ms),
+            fill();
+        size_t
+            writeGroup(const struct iovec *iov, int count);
+};
+
+#endif // ESC_POS_FD_STREAM_H
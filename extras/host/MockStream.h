@@ -0,0 +1,117 @@
+/*------------------------------------------------------------------------
+  A Stream that stands in for the printer on a host build.
+
+  Everything written is captured (unless capture is turned off) and the
+  number of write calls is counted, so both the bytes sent and the way
+  they were split into transfers can be checked.  Bytes queued with
+  reply() are what the "printer" sends back.
+  ------------------------------------------------------------------------*/
+
+#ifndef MOCK_STREAM_H
+#define MOCK_STREAM_H
+
+#include "Arduino.h"
+
+#include <vector>
+
+class MockStream : public Stream {
+
+    public:
+
+        MockStream() :
+            bytes(0), writes(0), capture(true), readPos(0), space(0) {
+            }
+
+        size_t write(uint8_t c) {
+            return write(&c, 1);
+        }
+
+        size_t write(const uint8_t *buf, size_t len) {
+            if(capture) append(out, buf, len);
+            bytes += len;
+            writes++;
+            return len;
+        }
+        using Print::write;
+
+        // What availableForWrite() reports; 0 (the default) means unknown
+        int availableForWrite() {
+            return space;
+        }
+
+        void setWriteSpace(int n) {
+            space = n;
+        }
+
+        int available() {
+            return (int)(in.size() - readPos);
+        }
+
+        int read() {
+            if(readPos >= in.size()) return -1;
+            return in[readPos++];
+        }
+
+        int peek() {
+            if(readPos >= in.size()) return -1;
+            return in[readPos];
+        }
+
+        // Queue bytes for read()
+        void reply(const uint8_t *buf, size_t len) {
+            append(in, buf, len);
+        }
+
+        void reply(uint8_t c) {
+            in.push_back(c);
+        }
+
+        // Keep counting but stop storing output, for long benchmarks
+        void setCapture(bool on) {
+            capture = on;
+        }
+
+        void clear() {
+            out.clear();
+            in.clear();
+            readPos = 0;
+            bytes   = 0;
+            writes  = 0;
+        }
+
+        const std::vector<uint8_t> &output() const {
+            return out;
+        }
+
+        size_t bytesWritten() const {
+            return bytes;
+        }
+
+        size_t writeCalls() const {
+            return writes;
+        }
+
+    private:
+
+        static void append(std::vector<uint8_t> &v, const uint8_t *buf, size_t len) {
+            if(len == 0) return;
+            size_t n = v.size();
+            v.resize(n + len);
+            memcpy(&v[n], buf, len);
+        }
+
+        std::vector<uint8_t>
+            out,
+            in;
+        size_t
+            bytes,
+            writes;
+        bool
+            capture;
+        size_t
+            readPos;
+        int
+            space;
+};
+
+#endif // MOCK_STREAM_H
@@ -0,0 +1,79 @@
+/*------------------------------------------------------------------------
+  Host version of the Arduino Print class.
+  ------------------------------------------------------------------------*/
+
+#ifndef PRINT_H
+#define PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+class __FlashStringHelper;
+
+class Print {
+
+    public:
+
+        Print() : write_error(0) {}
+        virtual ~Print() {}
+
+        virtual size_t
+            write(uint8_t c) = 0;
+        virtual size_t
+            write(const uint8_t *buffer, size_t size);
+        size_t
+            write(const char *str) {
+                if(str == NULL) return 0;
+                return write((const uint8_t *)str, strlen(str));
+            }
+        size_t
+            write(const char *buffer, size_t size) {
+                return write((const uint8_t *)buffer, size);
+            }
+        virtual int
+            availableForWrite() { return 0; }
+        virtual void
+            flush() {}
+
+        int
+            getWriteError() { return write_error; }
+        void
+            clearWriteError() { write_error = 0; }
+
+        size_t
+            print(const __FlashStringHelper *),
+            print(const char[]),
+            print(char),
+            print(unsigned char, int = 10),
+            print(int, int = 10),
+            print(unsigned int, int = 10),
+            print(long, int = 10),
+            print(unsigned long, int = 10),
+            print(double, int = 2),
+            println(const __FlashStringHelper *),
+            println(const char[]),
+            println(char),
+            println(unsigned char, int = 10),
+            println(int, int = 10),
+            println(unsigned int, int = 10),
+            println(long, int = 10),
+            println(unsigned long, int = 10),
+            println(double, int = 2),
+            println(void);
+
+    protected:
+
+        void
+            setWriteError(int err = 1) { write_error = err; }
+
+    private:
+
+        int
+            write_error;
+        size_t
+            printNumber(unsigned long, uint8_t),
+            printFloat(double, uint8_t);
+};
+
+#endif // PRINT_H
@@ -0,0 +1,41 @@
+/*------------------------------------------------------------------------
+  Host version of the Arduino Stream class.
+  ------------------------------------------------------------------------*/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+
+    public:
+
+        Stream() : _timeout(1000) {}
+
+        virtual int
+            available() = 0,
+            read() = 0,
+            peek() = 0;
+
+        void
+            setTimeout(unsigned long timeout) { _timeout = timeout; }
+        unsigned long
+            getTimeout() { return _timeout; }
+
+        virtual size_t
+            readBytes(char *buffer, size_t length);
+        size_t
+            readBytes(uint8_t *buffer, size_t length) {
+                return readBytes((char *)buffer, length);
+            }
+
+    protected:
+
+        unsigned long
+            _timeout;      // Milliseconds to wait for the next byte
+        int
+            timedRead();
+};
+
+#endif // STREAM_H
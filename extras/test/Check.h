@@ -0,0 +1,53 @@
+/*------------------------------------------------------------------------
+  Checks for the host tests in extras/test.
+
+  CHECK() reports a failed condition with its file and line and carries
+  on, so one run shows every failure.  A test program returns
+  checkResult() from main(), which ctest takes as pass or fail.
+  ------------------------------------------------------------------------*/
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static int checkFailures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if(!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            checkFailures++; \
+        } \
+    } while(0)
+
+// Bytes written to a MockStream equal a list of expected bytes
+#define CHECK_BYTES(out, ...) \
+    do { \
+        static const uint8_t expected[] = { __VA_ARGS__ }; \
+        CHECK(checkBytes(out, expected, sizeof(expected))); \
+    } while(0)
+
+static inline bool checkBytes(const std::vector<uint8_t> &out,
+        const uint8_t *expected, size_t len) {
+    return (out.size() == len) && !memcmp(out.data(), expected, len);
+}
+
+// Whether needle appears anywhere in out
+static inline bool contains(const std::vector<uint8_t> &out,
+        const void *needle, size_t len) {
+    if(out.size() < len) return false;
+    for(size_t i = 0; i + len <= out.size(); i++) {
+        if(!memcmp(&out[i], needle, len)) return true;
+    }
+    return false;
+}
+
+static inline int checkResult() {
+    if(checkFailures) printf("%d check(s) failed\n", checkFailures);
+    return checkFailures ? 1 : 0;
+}
+
+#endif // CHECK_H
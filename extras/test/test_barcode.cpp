@@ -0,0 +1,99 @@
+/*------------------------------------------------------------------------
+  Host tests of the Code 128 encoder: the data decodes back to the text,
+  code sets are chosen for the shortest symbol and bad text is refused.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "MockStream.h"
+#include "Check.h"
+
+#include <string>
+
+// Decode GS k function B data back to text, counting symbol characters
+// (start, code set changes, shifts and data) in symbols
+static std::string decode(const uint8_t *data, size_t len, int &symbols) {
+    std::string text;
+    char set = 0;
+
+    symbols = 0;
+    for(size_t i = 0; i < len; i++) {
+        symbols++;
+        if(data[i] == '{') {
+            char code = data[++i];
+            if(code == '{') text += '{';
+            else if(code != 'S') set = code;
+        } else if(set == 'C') {
+            text += (char)('0' + data[i] / 10);
+            text += (char)('0' + data[i] % 10);
+        } else {
+            text += (char)data[i];
+        }
+    }
+    return text;
+}
+
+static int encodedSymbols(const char *text) {
+    uint8_t out[255];
+    int symbols;
+    size_t len = encodeCode128((const uint8_t *)text, strlen(text), out, sizeof(out));
+
+    if(!len) return -1;
+    if(decode(out, len, symbols) != text) return -1;
+    return symbols;
+}
+
+static void testSets() {
+    uint8_t out[32];
+
+    // All digits: set C at two a symbol
+    size_t len = encodeCode128((const uint8_t *)"123456", 6, out, sizeof(out));
+    static const uint8_t digits[] = { '{', 'C', 12, 34, 56 };
+    CHECK((len == sizeof(digits)) && !memcmp(out, digits, len));
+
+    // Text and digits switch to C only where it saves symbols
+    CHECK(encodedSymbols("AB1234") == 6);   // {B A B {C 12 34
+    CHECK(encodedSymbols("AB12") == 5);     // {B A B 1 2
+    CHECK(encodedSymbols("12345") == 5);
+    CHECK(encodedSymbols("X123456789Y") == 10);
+
+    // Controls need set A, lower case set B; one odd byte is shifted
+    CHECK(encodedSymbols("\x01\x02" "a\x03") == 6);  // {A ^A ^B {S a ^C
+    CHECK(encodedSymbols("ab\x01" "cd") == 7);       // {B a b {S ^A c d
+    CHECK(encodedSymbols("{brace}") == 8);
+}
+
+static void testRefused() {
+    uint8_t out[255];
+    char text[ESC_POS_CODE128_MAX + 2];
+
+    memset(text, 'A', sizeof(text) - 1);
+    text[sizeof(text) - 1] = 0;
+    CHECK(encodeCode128((const uint8_t *)text, ESC_POS_CODE128_MAX, out, sizeof(out)) > 0);
+    CHECK(encodeCode128((const uint8_t *)text, ESC_POS_CODE128_MAX + 1, out, sizeof(out)) == 0);
+    CHECK(encodeCode128((const uint8_t *)"caf\xE9", 4, out, sizeof(out)) == 0);
+    CHECK(encodeCode128((const uint8_t *)"123456", 6, out, 4) == 0);
+}
+
+static void testPrintBarcode() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+
+    printer.reset();
+    printer.commit();
+    out.clear();
+    CHECK(printer.printBarcode("123456", CODE128));
+    CHECK_BYTES(out.output(), 0x1D, 'H', 2, 0x1D, 'w', 3,
+            0x1D, 'k', CODE128, 5, '{', 'C', 12, 34, 56);
+
+    // Text naming its own code sets is sent as it is
+    out.clear();
+    CHECK(printer.printBarcode("{B12", CODE128));
+    CHECK_BYTES(out.output(), 0x1D, 'k', CODE128, 4, '{', 'B', '1', '2');
+}
+
+int main() {
+    testSets();
+    testRefused();
+    testPrintBarcode();
+    return checkResult();
+}
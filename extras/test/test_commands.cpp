@@ -0,0 +1,110 @@
+/*------------------------------------------------------------------------
+  Host tests of command sequences (ESC_POS_Commands.h): the bytes sent,
+  the modes forgotten and the layout they change.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "ESC_POS_Commands.h"
+#include "MockStream.h"
+#include "Check.h"
+
+static const uint8_t feedLine[] = { 0x1B, 'd', 1 };
+
+// Whether a barcode had to feed out a part printed line first
+static bool lineOpen(ESC_POS_Printer &printer, MockStream &out) {
+    out.clear();
+    printer.printBarcode("1", CODE39);
+    return contains(out.output(), feedLine, sizeof(feedLine));
+}
+
+static void testSequence() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    typedef ESC_POS_Cat<ESC_POS_Justify<'C'>, ESC_POS_BoldOn,
+                        ESC_POS_Size<2, 2> >::type Title;
+
+    printer.reset();
+    printer.commit();
+    out.clear();
+    printer.command<Title>();
+    printer.commit();
+    CHECK_BYTES(out.output(), 0x1B, 'a', 1, 0x1B, 'E', 1, 0x1D, '!', 0x11);
+    CHECK(out.writeCalls() == 1);
+
+    // The modes it set are sent again rather than taken as known
+    out.clear();
+    printer.justify('C');
+    printer.boldOn();
+    printer.underlineOff(); // Not in the sequence, still known
+    printer.commit();
+    CHECK_BYTES(out.output(), 0x1B, 'a', 1, 0x1B, 'E', 1);
+}
+
+static void testLayout() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+
+    // Double width print mode: 16 columns, so 17 characters wrap
+    printer.reset();
+    printer.command<ESC_POS_PrintMode<0x20> >();
+    printer.print("12345678901234567");
+    CHECK(!lineOpen(printer, out));
+
+    // Print mode methods build on the mode the sequence set
+    out.clear();
+    printer.doubleHeightOn();
+    printer.commit();
+    CHECK_BYTES(out.output(), 0x1B, '!', 0x30);
+
+    // GS ! sets the width the same way; double width is 16 columns
+    printer.reset();
+    printer.command<ESC_POS_Size<2, 1> >();
+    printer.print("12345678901234567");
+    CHECK(!lineOpen(printer, out));
+    printer.command<ESC_POS_Size<1, 1> >();
+    printer.print("12345678901234567");
+    CHECK(lineOpen(printer, out));
+
+    // ESC @ puts it all back, and the printer may have lost stored data
+    uint16_t resets = printer.resetCount();
+    printer.command<ESC_POS_PrintMode<0x20> >();
+    printer.command<ESC_POS_Reset>();
+    CHECK(printer.resetCount() == resets + 1);
+    printer.print("12345678901234567");
+    CHECK(lineOpen(printer, out));
+
+    // Other commands in the sequence are stepped over
+    typedef ESC_POS_Cat<ESC_POS_Seq<0, 0x1D, '(', 'k', 4, 0, '1', 'A', '2', 0>,
+                        ESC_POS_Cut<1>, ESC_POS_PrintMode<0x20> >::type Mixed;
+    printer.command<Mixed>();
+    printer.print("12345678901234567");
+    CHECK(!lineOpen(printer, out));
+}
+
+// Microseconds a feed of one line takes, at 10 per row of dots
+static unsigned long lineFeedTime(ESC_POS_Printer &printer) {
+    MockStream sink;
+    printer.setTimes(0, 10);
+    printer.startCapture(&sink, false);
+    printer.feed(1);
+    return printer.endCapture();
+}
+
+static void testLineHeight() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+
+    printer.reset();
+    CHECK(lineFeedTime(printer) == 30 * 10);
+    printer.command<ESC_POS_LineHeight<64> >();
+    CHECK(lineFeedTime(printer) == 64 * 10);
+    printer.command<ESC_POS_DefaultLineHeight>();
+    CHECK(lineFeedTime(printer) == 30 * 10);
+}
+
+int main() {
+    testSequence();
+    testLayout();
+    testLineHeight();
+    return checkResult();
+}
@@ -0,0 +1,164 @@
+/*------------------------------------------------------------------------
+  Host tests of the dispatcher: jobs spread over three printers, a job on
+  a printer that runs out of paper is printed whole on another, and
+  printers without a queue take turns.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Dispatcher.h"
+#include "MockStream.h"
+#include "Check.h"
+
+#include <string>
+
+#define PRINTERS 3
+#define JOBS     6
+
+static uint8_t recordings[JOBS][2048];
+static size_t lengths[JOBS];
+
+// Record job j, 20 numbered lines
+static uint8_t submitJob(ESC_POS_Dispatcher &dispatcher,
+        ESC_POS_Printer &recorder, int j) {
+    ESC_POS_Receipt receipt(recordings[j], sizeof(recordings[j]));
+
+    receipt.record(recorder, false);
+    for(int k = 0; k < 20; k++) {
+        recorder.print("JOB ");
+        recorder.print(j);
+        recorder.print(" line ");
+        recorder.println(k);
+    }
+    recorder.feed(3);
+    receipt.stop();
+    lengths[j] = receipt.length();
+    return dispatcher.submit(receipt);
+}
+
+static bool hasJob(const MockStream &out, int j) {
+    return contains(out.output(), recordings[j], lengths[j]);
+}
+
+static void testFailover() {
+    MockStream out[PRINTERS], recorded;
+    ESC_POS_Printer *printers[PRINTERS];
+    static uint8_t queues[PRINTERS][256];
+    ESC_POS_Printer recorder(&recorded);
+    ESC_POS_Dispatcher dispatcher;
+    uint8_t ids[JOBS];
+
+    for(int i = 0; i < PRINTERS; i++) {
+        out[i].setWriteSpace(32);
+        printers[i] = new ESC_POS_Printer(&out[i]);
+        printers[i]->setQueue(queues[i], sizeof(queues[i]));
+        CHECK(dispatcher.addPrinter(*printers[i]));
+    }
+    for(int j = 0; j < JOBS; j++) {
+        ids[j] = submitJob(dispatcher, recorder, j);
+        CHECK(ids[j] != 0);
+    }
+    CHECK(dispatcher.waiting() == JOBS);
+    CHECK(dispatcher.jobState(ids[0]) == JOB_WAITING);
+
+    // All three printers start on the first poll
+    dispatcher.poll();
+    for(int i = 0; i < PRINTERS; i++) CHECK(out[i].bytesWritten() > 0);
+    CHECK(dispatcher.jobState(ids[0]) == JOB_PRINTING);
+    CHECK(dispatcher.jobState(ids[3]) == JOB_WAITING);
+    int8_t first = dispatcher.printerOf(ids[0]);
+    CHECK(first >= 0);
+
+    // The printer with the first job runs out of paper part way
+    while(out[first].bytesWritten() < 100) dispatcher.poll();
+    static const uint8_t paperOut[] = { 0x10, 0x00, 0x0C, 0x00 };
+    out[first].reply(paperOut, sizeof(paperOut));
+
+    for(int polls = 0; dispatcher.waiting() && (polls < 10000); polls++) {
+        dispatcher.poll();
+    }
+    CHECK(dispatcher.waiting() == 0);
+
+    // Every job printed whole once, none after the paper ran out
+    static const uint8_t clearBuffers[] = {
+        0x10, 0x14, 8, 1, 3, 20, 1, 6, 2, 8
+    };
+    CHECK(contains(out[first].output(), clearBuffers, sizeof(clearBuffers)));
+    CHECK(!hasJob(out[first], 0));
+    for(int j = 0; j < JOBS; j++) {
+        int copies = 0;
+        for(int i = 0; i < PRINTERS; i++) copies += hasJob(out[i], j);
+        CHECK(copies == 1);
+        CHECK(dispatcher.jobState(ids[j]) == JOB_DONE);
+        CHECK(dispatcher.printerOf(ids[j]) != first);
+    }
+    for(int i = 0; i < PRINTERS; i++) delete printers[i];
+}
+
+static void testIdleLongest() {
+    MockStream out[2], recorded;
+    ESC_POS_Printer a(&out[0]), b(&out[1]), recorder(&recorded);
+    static uint8_t queues[2][4096];
+    ESC_POS_Dispatcher dispatcher;
+
+    a.setQueue(queues[0], sizeof(queues[0]));
+    b.setQueue(queues[1], sizeof(queues[1]));
+    dispatcher.addPrinter(a);
+    dispatcher.addPrinter(b);
+
+    // b finishes a job later than a, so the next job goes to a
+    uint8_t first = submitJob(dispatcher, recorder, 0);
+    dispatcher.poll();
+    CHECK(dispatcher.printerOf(first) == 0);
+    while(dispatcher.waiting()) dispatcher.poll();
+    uint8_t second = submitJob(dispatcher, recorder, 1);
+    dispatcher.poll();
+    CHECK(dispatcher.printerOf(second) == 1);
+    while(dispatcher.waiting()) dispatcher.poll();
+    uint8_t third = submitJob(dispatcher, recorder, 2);
+    dispatcher.poll();
+    CHECK(dispatcher.printerOf(third) == 0);
+    while(dispatcher.waiting()) dispatcher.poll();
+
+    // Jobs are refused when every slot holds one not yet done
+    for(int j = 0; j < ESC_POS_DISPATCH_JOBS; j++) {
+        CHECK(dispatcher.submit(recordings[0], lengths[0]) != 0);
+    }
+    CHECK(dispatcher.submit(recordings[0], lengths[0]) == 0);
+}
+
+// Printers without a queue are fed a buffer's worth at each poll(), so
+// one long job does not hold up the others
+static void testNoQueue() {
+    MockStream out[2], recorded;
+    ESC_POS_Printer a(&out[0]), b(&out[1]), recorder(&recorded);
+    ESC_POS_Dispatcher dispatcher;
+
+    dispatcher.addPrinter(a);
+    dispatcher.addPrinter(b);
+    uint8_t first = submitJob(dispatcher, recorder, 0);
+    uint8_t second = submitJob(dispatcher, recorder, 1);
+    CHECK(lengths[0] > 2 * ESC_POS_BUFFER_SIZE);
+
+    dispatcher.poll();
+    CHECK(dispatcher.printerOf(first) == 0);
+    CHECK(dispatcher.printerOf(second) == 1);
+    CHECK(out[0].bytesWritten() == ESC_POS_BUFFER_SIZE);
+    CHECK(out[1].bytesWritten() == ESC_POS_BUFFER_SIZE);
+
+    int polls = 1;
+    while(dispatcher.waiting()) {
+        dispatcher.poll();
+        polls++;
+    }
+    CHECK(polls > 2);
+    CHECK(dispatcher.jobState(first) == JOB_DONE);
+    CHECK(dispatcher.jobState(second) == JOB_DONE);
+    CHECK(hasJob(out[0], 0));
+    CHECK(hasJob(out[1], 1));
+}
+
+int main() {
+    testFailover();
+    testIdleLongest();
+    testNoQueue();
+    return checkResult();
+}
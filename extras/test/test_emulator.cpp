@@ -0,0 +1,162 @@
+/*------------------------------------------------------------------------
+  Golden image tests: receipts, images, barcodes and QR codes are printed
+  into an ESC_POS_Emulator and the page is compared with a PBM file in
+  extras/test/golden.  After a deliberate change to the output, run with
+  ESC_POS_UPDATE_GOLDEN=1 in the environment to write new files, and look
+  at them before checking them in.  A page that differs is saved in the
+  current directory as <name>.actual.pbm.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "ESC_POS_Emulator.h"
+#include "ESC_POS_Table.h"
+#include "Check.h"
+
+#include <stdlib.h>
+#include <string>
+
+static std::string goldenDir = ".";
+
+// Read a binary PBM as a page of rows, width / 8 bytes each
+static bool loadPBM(const std::string &path, int &w, int &h,
+        std::vector<uint8_t> &bits) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if(!f) return false;
+    bool ok = (fscanf(f, "P4 %d %d", &w, &h) == 2) && (fgetc(f) == '\n');
+    if(ok) {
+        bits.resize((size_t)(w + 7) / 8 * h);
+        ok = fread(bits.data(), 1, bits.size(), f) == bits.size();
+    }
+    fclose(f);
+    return ok;
+}
+
+// Compare the emulator's page with golden/<name>.pbm
+static void checkGolden(ESC_POS_Emulator &emulator, const char *name) {
+    std::string path = goldenDir + "/" + name + ".pbm";
+
+    emulator.flushLine();
+    CHECK(emulator.unknown() == 0);
+    if(getenv("ESC_POS_UPDATE_GOLDEN")) {
+        CHECK(emulator.savePBM(path.c_str()));
+        return;
+    }
+
+    std::vector<uint8_t> page = emulator.page(), golden;
+    page.resize((size_t)emulator.width() / 8 * emulator.height()); // Fed rows
+    int w, h;
+    bool same = loadPBM(path, w, h, golden) && (w == emulator.width()) &&
+        (h == emulator.height()) && (golden == page);
+    if(!same) {
+        printf("%s differs from %s\n", name, path.c_str());
+        emulator.savePBM((std::string(name) + ".actual.pbm").c_str());
+    }
+    CHECK(same);
+}
+
+static void testReceipt() {
+    ESC_POS_Emulator emulator;
+    ESC_POS_Printer printer(&emulator);
+    static const ESC_POS_Column columns[] = {
+        { 3, 'R', false }, { 18, 'L', true }, { 8, 'R', false }
+    };
+    ESC_POS_Table table(columns, 3);
+    const char *rows[][3] = {
+        { "2", "Espresso", "5.00" },
+        { "1", "Almond croissant, warmed", "3.40" },
+        { "12", "Bagel", "15.00" }
+    };
+
+    printer.reset();
+    printer.justify('C');
+    printer.setSize('L');
+    printer.println("CAFE");
+    printer.setSize('S');
+    printer.boldOn();
+    printer.println("Receipt 42");
+    printer.boldOff();
+    printer.justify('L');
+    for(size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); i++)
+        table.printRow(printer, rows[i]);
+    printer.underlineOn();
+    printer.println("Subtotal                  23.40");
+    printer.underlineOff();
+    printer.inverseOn();
+    printer.doubleHeightOn();
+    printer.println(" TOTAL                    23.40 ");
+    printer.doubleHeightOff();
+    printer.inverseOff();
+    printer.justify('R');
+    printer.println("Thank you");
+    printer.feed(2);
+    checkGolden(emulator, "receipt");
+}
+
+static void testImages() {
+    ESC_POS_Emulator emulator;
+    ESC_POS_Printer printer(&emulator);
+    static uint8_t image[160 / 8 * 64];
+    static uint8_t gray[128 * 48];
+
+    // A ring with a checkered band across it
+    for(int y = 0; y < 64; y++) {
+        for(int x = 0; x < 160; x++) {
+            int dx = x - 80, dy = y - 32, r = dx * dx + dy * dy;
+            bool on = ((r > 20 * 20) && (r < 30 * 30)) ||
+                ((y >= 28) && (y < 36) && ((x / 8 + y / 4) & 1));
+            if(on) image[y * 20 + x / 8] |= 0x80 >> (x & 7);
+        }
+    }
+    for(int y = 0; y < 48; y++) {
+        for(int x = 0; x < 128; x++) gray[y * 128 + x] = x * 2;
+    }
+
+    printer.reset();
+    printer.printImage(160, 64, image, BITMAP_RASTER);
+    printer.printImage(160, 64, image, BITMAP_24DOT);
+    printer.printImage(160, 64, image, BITMAP_8DOT);
+    printer.justify('C');
+    printer.printImage(160, 64, image, BITMAP_RASTER);
+    printer.justify('L');
+    printer.printGrayscale(128, 48, gray);
+    printer.printGrayscale(128, 48, gray, DITHER_ORDERED);
+    printer.feed(1);
+    checkGolden(emulator, "images");
+}
+
+static void testBarcodes() {
+    ESC_POS_Emulator emulator;
+    ESC_POS_Printer printer(&emulator);
+
+    printer.reset();
+    printer.printBarcode("Order 12345678", CODE128);
+    printer.setBarcodeText(0);
+    printer.printBarcode("4006381333931", EAN13);
+    printer.setBarcodeWidth(2);
+    printer.printBarcode("ESC POS", CODE39);
+    printer.feed(1);
+    checkGolden(emulator, "barcodes");
+}
+
+static void testQRCodes() {
+    ESC_POS_Emulator emulator;
+    ESC_POS_Printer printer(&emulator);
+
+    printer.reset();
+    printer.justify('C');
+    printer.printQRCode("https://example.com/receipt/42", 4, 'M');
+    printer.setQRCodeNative(false);
+    printer.printQRCode("https://example.com/receipt/42", 4, 'M');
+    printer.printQRCode("HELLO", 6, 'H');
+    printer.feed(1);
+    checkGolden(emulator, "qrcodes");
+}
+
+int main(int argc, char **argv) {
+    if(argc > 1) goldenDir = argv[1];
+    testReceipt();
+    testImages();
+    testBarcodes();
+    testQRCodes();
+    return checkResult();
+}
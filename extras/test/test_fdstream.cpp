@@ -0,0 +1,162 @@
+/*------------------------------------------------------------------------
+  Host tests of ESC_POS_FdStream: gathered writes into a socket whose
+  buffer is much smaller than the data, so writev() goes out in pieces
+  and waits on EAGAIN, must arrive whole and in order.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_FdStream.h"
+#include "MockStream.h"
+#include "Check.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <thread>
+
+#define SOCKET_BUFFER 4096
+
+// The far end of a socket pair, read slowly on its own thread
+class SlowReader {
+
+    public:
+
+        SlowReader(int fd) : fd(fd), thread(&SlowReader::run, this) {
+        }
+
+        // Wait for the writer to close its end
+        std::vector<uint8_t> &finish() {
+            thread.join();
+            ::close(fd);
+            return received;
+        }
+
+    private:
+
+        void run() {
+            uint8_t buf[256];
+            ssize_t n;
+            while((n = ::read(fd, buf, sizeof(buf))) != 0) {
+                if(n > 0) received.insert(received.end(), buf, buf + n);
+                usleep(50);
+            }
+        }
+
+        int
+            fd;
+        std::vector<uint8_t>
+            received;
+        std::thread
+            thread;
+};
+
+static int sockets(int sv[2]) {
+    int size = SOCKET_BUFFER;
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv)) return -1;
+    setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(sv[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    socklen_t len = sizeof(size);
+    getsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &size, &len);
+    return size;
+}
+
+static void fill(std::vector<uint8_t> &buf, size_t len, uint8_t seed) {
+    buf.resize(len);
+    for(size_t i = 0; i < len; i++) buf[i] = (uint8_t)(seed + i * 7 + i / 251);
+}
+
+// Buffers of odd sizes, some empty, each far larger than the socket
+// takes at once
+static void testWritev() {
+    int sv[2], room = sockets(sv);
+    CHECK(room > 0);
+    static const size_t sizes[ESC_POS_FD_IOV] =
+        { 3, 70000, 0, 12345, 1, 40961, 0, 99999 };
+    std::vector<uint8_t> bufs[ESC_POS_FD_IOV], expected;
+    struct iovec iov[ESC_POS_FD_IOV];
+    for(int i = 0; i < ESC_POS_FD_IOV; i++) {
+        fill(bufs[i], sizes[i], (uint8_t)(i * 31));
+        iov[i].iov_base = bufs[i].data();
+        iov[i].iov_len  = sizes[i];
+        expected.insert(expected.end(), bufs[i].begin(), bufs[i].end());
+    }
+    CHECK(expected.size() > (size_t)room * 8);
+
+    ESC_POS_FdStream fs(sv[0]);
+    CHECK(fs.setNonBlocking());
+    SlowReader reader(sv[1]);
+    CHECK(fs.writev(iov, ESC_POS_FD_IOV) == expected.size());
+    // A second, overlapping gather: a short command then a long block
+    CHECK(fs.writeGather(bufs[4].data(), 1, bufs[1].data(), 20000) == 20001);
+    CHECK(fs.writeGather(NULL, 0, bufs[3].data(), 5000) == 5000);
+    CHECK(fs.getWriteError() == 0);
+    ::close(sv[0]);
+
+    expected.push_back(bufs[4][0]);
+    expected.insert(expected.end(), bufs[1].begin(), bufs[1].begin() + 20000);
+    expected.insert(expected.end(), bufs[3].begin(), bufs[3].begin() + 5000);
+    std::vector<uint8_t> &got = reader.finish();
+    CHECK(got.size() == expected.size());
+    CHECK(got == expected);
+}
+
+// More buffers than one system call takes go out in groups, all of them
+static void testManyBuffers() {
+    const int count = 3 * ESC_POS_FD_IOV + 3;
+    int sv[2];
+    CHECK(sockets(sv) > 0);
+    std::vector<uint8_t> bufs[count], expected;
+    struct iovec iov[count];
+    for(int i = 0; i < count; i++) {
+        fill(bufs[i], (i % 5) ? 1000 * i + 7 : 0, (uint8_t)(i * 17));
+        iov[i].iov_base = bufs[i].data();
+        iov[i].iov_len  = bufs[i].size();
+        expected.insert(expected.end(), bufs[i].begin(), bufs[i].end());
+    }
+
+    ESC_POS_FdStream fs(sv[0]);
+    CHECK(fs.setNonBlocking());
+    SlowReader reader(sv[1]);
+    CHECK(fs.writev(iov, count) == expected.size());
+    CHECK(fs.getWriteError() == 0);
+    ::close(sv[0]);
+
+    std::vector<uint8_t> &got = reader.finish();
+    CHECK(got.size() == expected.size());
+    CHECK(got == expected);
+}
+
+// A printer gathering bitmap bands through the socket sends the same
+// bytes as one writing them plainly
+static void testPrinterGather() {
+    static uint8_t bitmap[48 * 600];
+    for(size_t i = 0; i < sizeof(bitmap); i++) bitmap[i] = (uint8_t)(i * 13 + i / 48);
+
+    MockStream out;
+    ESC_POS_Printer plain(&out);
+    plain.begin();
+    plain.printBitmap(384, 600, bitmap, false);
+    plain.feed(2);
+
+    int sv[2];
+    CHECK(sockets(sv) > 0);
+    ESC_POS_FdStream fs(sv[0]);
+    CHECK(fs.setNonBlocking());
+    SlowReader reader(sv[1]);
+    ESC_POS_Printer printer(&fs);
+    printer.setGather(&fs);
+    printer.begin();
+    printer.printBitmap(384, 600, bitmap, false);
+    printer.feed(2);
+    CHECK(fs.getWriteError() == 0);
+    ::close(sv[0]);
+
+    std::vector<uint8_t> &got = reader.finish();
+    CHECK(got.size() == out.output().size());
+    CHECK(got == out.output());
+}
+
+int main() {
+    testWritev();
+    testManyBuffers();
+    testPrinterGather();
+    return checkResult();
+}
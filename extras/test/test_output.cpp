@@ -0,0 +1,117 @@
+/*------------------------------------------------------------------------
+  Host tests of text output: bulk writes against byte by byte writes,
+  buffering, and mode commands skipped when they would change nothing.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "MockStream.h"
+#include "Check.h"
+
+// Text with line ends, a stripped DC3, wraps past the 32 column page and
+// a line that stops part way, each followed by a tab that depends on the
+// column the text left.
+static const char *texts[] = {
+    "Hello\n",
+    "abc",
+    "0123456789012345678901234567890123456789012345678901234567890123456789",
+    "x\x13y\n\nz",
+    "",
+    "01234567890123456789012345678901",
+    "tail\n"
+};
+
+static void printTexts(ESC_POS_Printer &printer, bool bulk) {
+    for(size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); i++) {
+        if(bulk) {
+            printer.write((const uint8_t *)texts[i], strlen(texts[i]));
+        } else {
+            for(const char *p = texts[i]; *p; p++) printer.write((uint8_t)*p);
+        }
+        printer.tab();
+        printer.print('|');
+    }
+    printer.println();
+}
+
+static void testBulkMatchesBytes() {
+    MockStream bulkOut, byteOut;
+    ESC_POS_Printer bulk(&bulkOut), bytes(&byteOut);
+
+    bulk.reset();
+    bytes.reset();
+    printTexts(bulk, true);
+    printTexts(bytes, false);
+    CHECK(bulkOut.output() == byteOut.output());
+}
+
+static void testBuffering() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    char line[1001];
+
+    memset(line, 'a', 1000);
+    line[1000] = 0;
+    printer.setAutoCommit(false);
+    printer.print(line);
+    CHECK(out.writeCalls() <= 1000 / ESC_POS_BUFFER_SIZE);
+    printer.commit();
+    CHECK(out.bytesWritten() == 1000);
+
+    // With auto commit each line goes out in one write
+    out.clear();
+    printer.setAutoCommit(true);
+    printer.println("one line");
+    printer.println("another");
+    CHECK(out.writeCalls() == 2);
+}
+
+static void testShadowModes() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+
+    printer.reset();
+    printer.commit();
+    out.clear();
+
+    // ESC @ leaves bold off and left justified
+    printer.boldOff();
+    printer.justify('L');
+    printer.commit();
+    CHECK(out.bytesWritten() == 0);
+
+    printer.boldOn();
+    printer.boldOn();
+    printer.justify('C');
+    printer.justify('c');
+    printer.boldOff();
+    printer.commit();
+    CHECK_BYTES(out.output(), 0x1B, 'E', 1, 0x1B, 'a', 1, 0x1B, 'E', 0);
+
+    // Nothing is trusted after invalidateState()
+    out.clear();
+    uint16_t resets = printer.resetCount();
+    printer.invalidateState();
+    CHECK(printer.resetCount() == resets + 1);
+    printer.boldOff();
+    printer.boldOff();
+    printer.commit();
+    CHECK_BYTES(out.output(), 0x1B, 'E', 0);
+
+    // Commands sent while offline are ignored by the printer, so they
+    // are sent again once it is back online
+    out.clear();
+    printer.offline();
+    printer.underlineOn();
+    printer.online();
+    printer.underlineOn();
+    printer.commit();
+    CHECK_BYTES(out.output(), 0x1B, '=', 0, 0x1B, '-', 1, 0x1B, '=', 1,
+            0x1B, '-', 1);
+}
+
+int main() {
+    testBulkMatchesBytes();
+    testBuffering();
+    testShadowModes();
+    return checkResult();
+}
@@ -0,0 +1,88 @@
+/*------------------------------------------------------------------------
+  Host tests of flow control: output stops on XOFF and goes on after XON.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "MockStream.h"
+#include "Check.h"
+
+// A printer with a small buffer: it sends XOFF once xoffAt bytes have
+// arrived, and XON after being asked for input a few more times.
+class XoffStream : public MockStream {
+
+    public:
+
+        XoffStream(size_t xoffAt) :
+            xoffAt(xoffAt), reads(0), stopped(false), resumed(false),
+            afterXoff(0) {
+            }
+
+        size_t write(const uint8_t *buf, size_t len) {
+            if(stopped && !resumed) afterXoff += len;
+            MockStream::write(buf, len);
+            if(!stopped && (bytesWritten() >= xoffAt)) {
+                reply(0x13);
+                stopped = true;
+            }
+            return len;
+        }
+        using MockStream::write;
+
+        int available() {
+            if(stopped && !resumed && (++reads > 10)) {
+                reply(0x11);
+                resumed = true;
+            }
+            return MockStream::available();
+        }
+
+        size_t
+            xoffAt;
+        int
+            reads;
+        bool
+            stopped,
+            resumed;
+        size_t
+            afterXoff;     // Bytes written between XOFF and XON
+};
+
+static void testXonXoff() {
+    XoffStream out(100);
+    ESC_POS_Printer printer(&out);
+    uint8_t job[3000];
+
+    for(size_t i = 0; i < sizeof(job); i++) job[i] = i * 7;
+    printer.setXonXoff(true);
+    printer.replay(job, sizeof(job));
+
+    CHECK(out.stopped && out.resumed);
+    CHECK(out.afterXoff == 0);
+    CHECK(out.reads > 10);
+    CHECK(out.bytesWritten() == sizeof(job));
+    CHECK(out.writeCalls() >= sizeof(job) / ESC_POS_POLL_CHUNK);
+    CHECK(checkBytes(out.output(), job, sizeof(job)));
+}
+
+static void testQueuedXoff() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    uint8_t queue[256];
+
+    printer.setXonXoff(true);
+    printer.setQueue(queue, sizeof(queue));
+    printer.println("Held until XON");
+    size_t job = printer.queued();
+    out.reply(0x13);
+    CHECK(printer.poll() == 0);
+    CHECK(out.bytesWritten() == 0);
+    out.reply(0x11);
+    CHECK(printer.poll() == job);
+    CHECK(printer.queued() == 0);
+}
+
+int main() {
+    testXonXoff();
+    testQueuedXoff();
+    return checkResult();
+}
@@ -0,0 +1,86 @@
+/*------------------------------------------------------------------------
+  Host tests of printer profiles: printers with different profiles side
+  by side in one program, or one profile fixed at compile time.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "MockStream.h"
+#include "Check.h"
+
+#if ESC_POS_PROFILE_FIXED
+// Built with one profile: every printer has it, whatever it is given
+static void testFixed() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+
+    CHECK(printer.profile().dots == ESC_POS_PROFILE.dots);
+    CHECK(printer.profile().columns == ESC_POS_PROFILE.columns);
+    CHECK(printer.profile().cutter == ESC_POS_PROFILE.cutter);
+    CHECK(ESC_POS_IMAGE_MAX_WIDTH == ESC_POS_PROFILE.dots);
+}
+#else
+static void testMixedPrinters() {
+    MockStream narrowOut, wideOut, basicOut;
+    ESC_POS_Printer narrow(&narrowOut), wide(&wideOut, ESC_POS_80mm),
+        basic(&basicOut, ESC_POS_58mmBasic);
+
+    CHECK(narrow.profile().dots == 384);
+    CHECK(wide.profile().dots == 576);
+    CHECK(!basic.profile().qrCode);
+
+    // Only the 80 mm printer has a cutter
+    narrow.cut();
+    wide.cut();
+    CHECK_BYTES(narrowOut.output(), 0x1B, 'd', 3);
+    CHECK_BYTES(wideOut.output(), 0x1D, 'V', 65, 0);
+
+    // Text wraps after 33 characters on 58 mm paper, leaving the next
+    // line clear for a barcode; on 80 mm it has to be fed out first
+    narrow.reset();
+    wide.reset();
+    narrow.print("123456789012345678901234567890123");
+    wide.print("123456789012345678901234567890123");
+    narrowOut.clear();
+    wideOut.clear();
+    narrow.printBarcode("1", CODE39);
+    wide.printBarcode("1", CODE39);
+    static const uint8_t feed[] = { 0x1B, 'd', 1 };
+    CHECK(!contains(narrowOut.output(), feed, sizeof(feed)));
+    CHECK(contains(wideOut.output(), feed, sizeof(feed)));
+
+    // QR codes: GS ( k on the 58 mm printer, graphics on the basic one
+    narrowOut.clear();
+    CHECK(narrow.printQRCode("profile"));
+    static const uint8_t qrModel[] = { 0x1D, '(', 'k', 4, 0, '1', 'A', '2', 0 };
+    CHECK(contains(narrowOut.output(), qrModel, sizeof(qrModel)));
+    CHECK(basic.printQRCode("profile"));
+    CHECK(!contains(basicOut.output(), qrModel, sizeof(qrModel)));
+    static const uint8_t escStar[] = { 0x1B, '*', 33 };
+    CHECK(contains(basicOut.output(), escStar, sizeof(escStar)));
+}
+
+static void testImageWidth() {
+    MockStream narrowOut, wideOut;
+    ESC_POS_Printer narrow(&narrowOut), wide(&wideOut, ESC_POS_80mm);
+    static uint8_t image[576 / 8 * 24];
+
+    // A 576 dot image is clipped to the paper of the 58 mm printer only
+    memset(image, 0xFF, sizeof(image));
+    narrow.printImage(576, 24, image, BITMAP_RASTER);
+    wide.printImage(576, 24, image, BITMAP_RASTER);
+    static const uint8_t narrowRaster[] = { 0x1D, 'v', '0', 0, 48, 0, 24, 0 };
+    static const uint8_t wideRaster[] = { 0x1D, 'v', '0', 0, 72, 0, 24, 0 };
+    CHECK(contains(narrowOut.output(), narrowRaster, sizeof(narrowRaster)));
+    CHECK(contains(wideOut.output(), wideRaster, sizeof(wideRaster)));
+}
+#endif
+
+int main() {
+#if ESC_POS_PROFILE_FIXED
+    testFixed();
+#else
+    testMixedPrinters();
+    testImageWidth();
+#endif
+    return checkResult();
+}
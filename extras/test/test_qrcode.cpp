@@ -0,0 +1,118 @@
+/*------------------------------------------------------------------------
+  Host tests of the QR code encoder against symbols made by another
+  encoder (python-qrcode 8.2, byte mode, the mask given), so a fault
+  shared with the emulator's drawing of GS ( k cannot hide.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_QRCode.h"
+#include "Check.h"
+
+// "Hello, world!" at level Q with mask 5: version 2
+static const char *const helloQ5[] = {
+    "#######.##..#..##.#######",
+    "#.....#.#.#.###.#.#.....#",
+    "#.###.#....###.#..#.###.#",
+    "#.###.#..##.....#.#.###.#",
+    "#.###.#..###...##.#.###.#",
+    "#.....#..##....#..#.....#",
+    "#######.#.#.#.#.#.#######",
+    ".........#.##.###........",
+    ".#....###.###...##.....##",
+    "#.###...######..##.###...",
+    ".#..#.#.###..####.####.##",
+    ".#.....#....##.....###.##",
+    "#...###.#..###.##.##.#..#",
+    "####.#.#.#####..#..#.##..",
+    "#.#..###.#.......#.###.##",
+    "#..#.#...#######..#####.#",
+    "#....####.#.#.#.#######..",
+    "........#..#.##.#...###.#",
+    "#######.###..#.##.#.#...#",
+    "#.....#..#.#.#..#...#..##",
+    "#.###.#...#.############.",
+    "#.###.#.......######.#..#",
+    "#.###.#.....##.#...#.#..#",
+    "#.....#.##.##...###.....#",
+    "#######..####..#######..#",
+};
+
+// "https://example.com/esc-pos" at level M with mask 3: version 3
+static const char *const exampleM3[] = {
+    "#######.##.....##.###.#######",
+    "#.....#.#...#.##......#.....#",
+    "#.###.#....#####..#...#.###.#",
+    "#.###.#.####....###.#.#.###.#",
+    "#.###.#...##.#.....#..#.###.#",
+    "#.....#...#...#...###.#.....#",
+    "#######.#.#.#.#.#.#.#.#######",
+    "........####.##..##..........",
+    "#.##.###..#.###.####..#..#.##",
+    "#....#..#..#...##..##.###...#",
+    "##.##.#...#...##.#........##.",
+    "..###..#...#.###....#.###...#",
+    "#########..#....##.#.....##..",
+    ".####..###..##.....##.#...###",
+    "....#.##.#.#..#..#####.#..###",
+    ".....#...#.#.#.#....##..#..#.",
+    "##.#.##...#.......####.###.#.",
+    "....##..#.#..#....#.#..#.###.",
+    "#..#.###.##......##.#...#.#..",
+    "....##.#.#..#..#####.#.##.#..",
+    ".#...##..#####.#....#######..",
+    "........#...####.##.#...#####",
+    "#######.###.##..#.###.#.##.#.",
+    "#.....#.##.##...##..#...##.#.",
+    "#.###.#....##.##....#####.###",
+    "#.###.#.##....#.##.#....##.#.",
+    "#.###.#.#..#..###..#...#..#.#",
+    "#.....#..#......#...#.####.#.",
+    "#######.######.###.##.#....#.",
+};
+
+static bool same(ESC_POS_QRCode &qr, const char *const *rows, int size) {
+    if(qr.size() != size) return false;
+    for(int y = 0; y < size; y++) {
+        for(int x = 0; x < size; x++) {
+            if(qr.module(x, y) != (rows[y][x] == '#')) {
+                printf("module %d,%d differs\n", x, y);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void testKnownSymbols() {
+    ESC_POS_QRCode qr;
+    const char *hello = "Hello, world!";
+    CHECK(qr.encode((const uint8_t *)hello, strlen(hello), 'Q', 5));
+    CHECK(same(qr, helloQ5, 25));
+
+    const char *example = "https://example.com/esc-pos";
+    CHECK(qr.encode((const uint8_t *)example, strlen(example), 'M', 3));
+    CHECK(same(qr, exampleM3, 29));
+}
+
+// A mask out of range picks the best one, as -1 does
+static void testMaskOutOfRange() {
+    const char *example = "https://example.com/esc-pos";
+    ESC_POS_QRCode best, wild;
+    CHECK(best.encode((const uint8_t *)example, strlen(example), 'M', -1));
+    for(int8_t mask = 8; mask <= 9; mask++) {
+        CHECK(wild.encode((const uint8_t *)example, strlen(example), 'M', mask));
+        CHECK(wild.size() == best.size());
+        bool match = true;
+        for(int y = 0; y < best.size(); y++) {
+            for(int x = 0; x < best.size(); x++) {
+                if(wild.module(x, y) != best.module(x, y)) match = false;
+            }
+        }
+        CHECK(match);
+    }
+}
+
+int main() {
+    testKnownSymbols();
+    testMaskOutOfRange();
+    return checkResult();
+}
@@ -0,0 +1,94 @@
+/*------------------------------------------------------------------------
+  Host tests of the print queue: poll() writes what the stream can take,
+  real-time commands go first and the output matches unqueued output.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "MockStream.h"
+#include "Check.h"
+
+static void printJob(ESC_POS_Printer &printer) {
+    printer.boldOn();
+    printer.println("Queued receipt");
+    printer.boldOff();
+    for(int i = 0; i < 8; i++) printer.println("1 x Item              1.00");
+    printer.feed(2);
+}
+
+static void testPoll() {
+    MockStream out, direct;
+    ESC_POS_Printer printer(&out), reference(&direct);
+    uint8_t queue[512];
+
+    printJob(reference);
+
+    printer.setQueue(queue, sizeof(queue));
+    CHECK(printer.queueRoom() == sizeof(queue));
+    printJob(printer);
+    CHECK(out.bytesWritten() == 0);
+    CHECK(printer.queued() == direct.bytesWritten());
+    CHECK(printer.queueRoom() == sizeof(queue) - printer.queued());
+
+    // Streams that never report space get ESC_POS_POLL_CHUNK at a time
+    CHECK(printer.poll() == ESC_POS_POLL_CHUNK);
+
+    // Real-time commands jump the queue
+    static const uint8_t enq[] = { 0x10, 0x05, 2 };
+    CHECK(printer.realtime(enq, sizeof(enq)));
+    out.setWriteSpace(8);
+    size_t before = out.output().size();
+    CHECK(printer.poll() == 8);
+    CHECK(!memcmp(&out.output()[before], enq, sizeof(enq)));
+
+    while(printer.queued()) CHECK(printer.poll() > 0);
+    std::vector<uint8_t> sent = out.output();
+    sent.erase(sent.begin() + before, sent.begin() + before + sizeof(enq));
+    CHECK(sent == direct.output());
+    CHECK(printer.poll() == 0);
+}
+
+static void testOverflow() {
+    MockStream out, direct;
+    ESC_POS_Printer printer(&out), reference(&direct);
+    uint8_t queue[40];
+
+    // A queue too small for the job blocks to make room, and output
+    // bigger than the whole queue goes straight out, in order
+    printer.setQueue(queue, sizeof(queue));
+    printJob(printer);
+    printJob(reference);
+    CHECK(printer.queued() <= sizeof(queue));
+    CHECK(out.bytesWritten() + printer.queued() == direct.bytesWritten());
+    printer.setQueue(NULL, 0);
+    CHECK(printer.queued() == 0);
+    CHECK(out.output() == direct.output());
+
+    // Without a queue the priority lane is not used
+    out.clear();
+    static const uint8_t eot[] = { 0x10, 0x04, 1 };
+    CHECK(printer.realtime(eot, sizeof(eot)));
+    CHECK_BYTES(out.output(), 0x10, 0x04, 1);
+    CHECK(printer.queueRoom() == (size_t)-1);
+}
+
+static void testPriorityFull() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    uint8_t queue[64];
+    static const uint8_t eot[] = { 0x10, 0x04, 1 };
+
+    printer.setQueue(queue, sizeof(queue));
+    int sent = 0;
+    while(printer.realtime(eot, sizeof(eot))) sent++;
+    CHECK(sent == ESC_POS_PRIORITY_SIZE / sizeof(eot));
+    printer.poll();
+    CHECK(printer.queued() == 0);
+    CHECK(printer.realtime(eot, sizeof(eot)));
+}
+
+int main() {
+    testPoll();
+    testOverflow();
+    testPriorityFull();
+    return checkResult();
+}
@@ -0,0 +1,130 @@
+/*------------------------------------------------------------------------
+  Host tests of recorded receipts: copies print the same page, recording
+  without printing sends nothing, and what the printer never got is not
+  taken as stored in it.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "ESC_POS_Emulator.h"
+#include "ESC_POS_ImageCache.h"
+#include "ESC_POS_Receipt.h"
+#include "MockStream.h"
+#include "Check.h"
+
+static uint8_t logo[64 / 8 * 32];
+
+static void printJob(ESC_POS_Printer &printer) {
+    printer.justify('C');
+    printer.boldOn();
+    printer.println("STORE NAME");
+    printer.boldOff();
+    printer.justify('L');
+    for(int i = 0; i < 6; i++) {
+        printer.print("Item ");
+        printer.print(i);
+        printer.println("               1.99");
+    }
+    printer.setSize('M');
+    printer.println("TOTAL 11.94");
+    printer.setSize('S');
+    printer.printBarcode("123456789012", CODE128);
+    printer.feed(2);
+}
+
+static std::vector<uint8_t> page(ESC_POS_Emulator &emulator) {
+    emulator.flushLine();
+    std::vector<uint8_t> bits = emulator.page();
+    emulator.clear();
+    return bits;
+}
+
+static void testCopies() {
+    ESC_POS_Emulator emulator;
+    ESC_POS_Printer printer(&emulator);
+    static uint8_t buffer[2048];
+    ESC_POS_Receipt receipt(buffer, sizeof(buffer));
+
+    printer.reset();
+    receipt.record(printer);
+    printJob(printer);
+    CHECK(receipt.stop());
+    std::vector<uint8_t> original = page(emulator);
+    CHECK(!original.empty());
+
+    // A copy prints the same whatever modes were left behind
+    printer.justify('R');
+    printer.boldOn();
+    printer.setSize('L');
+    printer.underlineOn();
+    printer.commit();
+    emulator.clear();
+    CHECK(receipt.replay(printer));
+    CHECK(page(emulator) == original);
+
+    // Recording only: nothing is printed until replay()
+    static uint8_t buffer2[2048];
+    ESC_POS_Receipt later(buffer2, sizeof(buffer2));
+    printer.reset();
+    later.record(printer, false);
+    printJob(printer);
+    CHECK(later.stop());
+    printer.commit();
+    CHECK(page(emulator).empty());
+    CHECK(later.replay(printer));
+    CHECK(page(emulator) == original);
+
+    // A recording that did not fit is not printed
+    static uint8_t small[64];
+    ESC_POS_Receipt tooSmall(small, sizeof(small));
+    tooSmall.record(printer, false);
+    printJob(printer);
+    CHECK(!tooSmall.stop());
+    CHECK(!tooSmall.replay(printer));
+}
+
+static void testRecordOnlyForgets() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    ESC_POS_ImageCache cache(printer);
+    static uint8_t buffer[1024];
+    ESC_POS_Receipt receipt(buffer, sizeof(buffer));
+
+    for(size_t i = 0; i < sizeof(logo); i++) logo[i] = i * 13;
+    printer.reset();
+    printer.commit();
+    out.clear();
+
+    // The image is stored into the recording, not the printer
+    uint16_t resets = printer.resetCount();
+    receipt.record(printer, false);
+    printer.boldOn();
+    CHECK(cache.printImage(1, 64, 32, logo));
+    CHECK(receipt.stop());
+    CHECK(out.bytesWritten() == 0);
+    CHECK(printer.resetCount() != resets);
+
+    // So printing it for real sends the image again, and bold is sent
+    // though the recording turned it on
+    CHECK(cache.printImage(1, 64, 32, logo));
+    CHECK(out.bytesWritten() > sizeof(logo));
+    out.clear();
+    printer.boldOn();
+    printer.commit();
+    CHECK_BYTES(out.output(), 0x1B, 'E', 1);
+
+    // Recording while printing keeps what it knows
+    resets = printer.resetCount();
+    receipt.record(printer);
+    printer.println("printed");
+    CHECK(receipt.stop());
+    CHECK(printer.resetCount() == resets);
+    out.clear();
+    CHECK(cache.printImage(1, 64, 32, logo));
+    CHECK(out.bytesWritten() < 16);
+}
+
+int main() {
+    testCopies();
+    testRecordOnlyForgets();
+    return checkResult();
+}
@@ -0,0 +1,71 @@
+/*------------------------------------------------------------------------
+  Host tests of output statistics (ESC_POS_STATS): bytes and commands by
+  kind, dot rows, and the estimates made from them for a fixed job.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "MockStream.h"
+#include "Check.h"
+
+// Bold "Hello", a two line feed and a 24 x 24 bitmap
+static void printJob(ESC_POS_Printer &printer) {
+    static const uint8_t bitmap[3 * 24] = { 0 };
+
+    printer.boldOn();
+    printer.println("Hello");
+    printer.boldOff();
+    printer.feed(2);
+    printer.printBitmap(24, 24, bitmap, false);
+    printer.commit();
+}
+
+static void testJob() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    printer.begin();
+    printer.commit();
+    out.clear();
+
+    printer.startJob();
+    printJob(printer);
+    ESC_POS_Stats job = printer.jobStats();
+
+    // "Hello\r\n"; ESC E 1 and ESC E 0; DC2 * with 72 bytes of data; ESC d 2
+    CHECK(job.bytes[STAT_TEXT] == 7);
+    CHECK(job.commands[STAT_TEXT] == 0);
+    CHECK(job.bytes[STAT_STYLE] == 6);
+    CHECK(job.commands[STAT_STYLE] == 2);
+    CHECK(job.bytes[STAT_IMAGE] == 4 + 72);
+    CHECK(job.commands[STAT_IMAGE] == 1);
+    CHECK(job.bytes[STAT_FEED] == 3);
+    CHECK(job.commands[STAT_FEED] == 1);
+    CHECK(job.bytes[STAT_BARCODE] == 0);
+    CHECK(job.bytes[STAT_OTHER] == 0);
+    CHECK(job.totalBytes() == out.bytesWritten());
+
+    // A 24 dot text line and the bitmap are printed; the text line's
+    // spacing (6 dots) and two 30 dot lines are fed
+    CHECK(job.printRows == 24 + 24);
+    CHECK(job.feedRows == 6 + 2 * 30);
+
+    // 92 bytes at 9600 baud, 11 bits each: 105.4 ms
+    CHECK(job.transferMillis(9600) == 105);
+    CHECK(job.transferMillis(0) == 0);
+    // 48 rows at 2 ms and 66 at 0.5 ms
+    CHECK(job.printMillis(2000, 500) == 96 + 33);
+    // 114 rows at 8 dots a millimetre
+    CHECK(job.paperMillimetres() == 14);
+
+    // The printer's totals include begin(); a new job starts from zero
+    CHECK(printer.stats().totalBytes() > job.totalBytes());
+    printer.startJob();
+    CHECK(printer.jobStats().totalBytes() == 0);
+    printJob(printer);
+    CHECK(printer.jobStats().totalBytes() == job.totalBytes());
+    CHECK(printer.jobStats().printRows == job.printRows);
+}
+
+int main() {
+    testJob();
+    return checkResult();
+}
@@ -0,0 +1,179 @@
+/*------------------------------------------------------------------------
+  Host tests of printer status from Automatic Status Back messages and
+  DLE EOT replies.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "MockStream.h"
+#include "Check.h"
+
+static uint8_t lastStatus, lastChanged;
+static int callbacks;
+
+static void statusChanged(uint8_t status, uint8_t changed) {
+    lastStatus  = status;
+    lastChanged = changed;
+    callbacks++;
+}
+
+static void testAutomaticStatusBack() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+
+    CHECK(printer.status() == 0);
+    printer.onStatusChange(statusChanged);
+    callbacks = 0;
+
+    // Offline, paper out
+    static const uint8_t paperOut[] = { 0x18, 0x00, 0x0C, 0x00 };
+    out.reply(paperOut, sizeof(paperOut));
+    CHECK(printer.status() ==
+            (STATUS_KNOWN | STATUS_OFFLINE | STATUS_PAPER_OUT));
+    CHECK(!printer.hasPaper());
+    CHECK(callbacks == 1);
+    CHECK(lastChanged == (STATUS_KNOWN | STATUS_OFFLINE | STATUS_PAPER_OUT));
+
+    // A message split across reads, with XON in the middle, clears it
+    static const uint8_t head[] = { 0x10, 0x00 }, tail[] = { 0x11, 0x00, 0x00 };
+    out.reply(head, sizeof(head));
+    CHECK(printer.status() & STATUS_PAPER_OUT);
+    out.reply(tail, sizeof(tail));
+    CHECK(printer.status() == STATUS_KNOWN);
+    CHECK(callbacks == 2);
+    CHECK(lastStatus == STATUS_KNOWN);
+
+    // A byte that cannot continue the message starts over
+    static const uint8_t broken[] = { 0x10, 0x00, 0x1C, 0x00, 0x0C, 0x00 };
+    out.reply(broken, sizeof(broken));
+    CHECK(printer.status() == (STATUS_KNOWN | STATUS_PAPER_OUT | STATUS_OFFLINE |
+            STATUS_DRAWER));
+}
+
+static void testRealTimeStatus() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+
+    // Replies are matched to requests oldest first
+    CHECK(printer.requestStatus(1));
+    CHECK(printer.requestStatus(4));
+    CHECK(printer.requestStatus(4)); // Already waiting, not sent again
+    CHECK(!printer.requestStatus(5));
+    CHECK_BYTES(out.output(), 0x10, 0x04, 1, 0x10, 0x04, 4);
+
+    out.reply(0x1A); // 1: offline
+    CHECK(printer.status() == (STATUS_KNOWN | STATUS_OFFLINE));
+    out.reply(0x7E); // 4: near end and out
+    CHECK(printer.status() ==
+            (STATUS_KNOWN | STATUS_OFFLINE | STATUS_PAPER_NEAR_END | STATUS_PAPER_OUT));
+
+    // A reply nobody asked for changes nothing
+    out.reply(0x12);
+    CHECK(printer.status() & STATUS_PAPER_OUT);
+
+    // hasPaper() answers from what is known and asks again
+    out.clear();
+    CHECK(!printer.hasPaper());
+    CHECK_BYTES(out.output(), 0x10, 0x04, 4);
+    out.reply(0x12);
+    CHECK(printer.hasPaper());
+    CHECK(!(printer.status() & STATUS_PAPER_NEAR_END));
+    CHECK(printer.status() & STATUS_OFFLINE);
+
+    // hasPaper() asked for 4 again; a request for 1 waits behind it
+    CHECK(printer.requestStatus(1));
+    out.clear();
+    CHECK(printer.requestStatus(4)); // Still waiting
+    CHECK(out.bytesWritten() == 0);
+    out.reply(0x12);                 // Answers 4
+    CHECK(printer.status() & STATUS_OFFLINE);
+    out.reply(0x12);                 // Answers 1
+    CHECK(!(printer.status() & STATUS_OFFLINE));
+}
+
+static void testStatusTimeout() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+
+    // A request with no reply is given up and sent again
+    CHECK(printer.requestStatus(4));
+    CHECK(printer.requestStatus(4));
+    CHECK(out.bytesWritten() == 3);
+    delay(ESC_POS_STATUS_TIMEOUT);
+    CHECK(printer.requestStatus(4));
+    CHECK(out.bytesWritten() == 6);
+
+    // A reply arriving after its request expired is not used
+    CHECK(printer.requestStatus(1));
+    delay(ESC_POS_STATUS_TIMEOUT);
+    out.reply(0x1A);
+    CHECK(printer.status() == 0);
+
+    // Nor are replies to requests made before a reset
+    CHECK(printer.requestStatus(1));
+    printer.reset();
+    out.reply(0x1A);
+    CHECK(printer.status() == 0);
+    CHECK(printer.requestStatus(2));
+    printer.invalidateState();
+    out.reply(0x1A);
+    CHECK(printer.status() == 0);
+}
+
+// A printer that answers DLE EOT 4 a few reads after being asked, or
+// never if answer is negative
+class PaperSensor : public MockStream {
+
+    public:
+
+        PaperSensor(int answer) : answer(answer), asked(0) {
+        }
+
+        size_t write(const uint8_t *buf, size_t len) {
+            static const uint8_t request[] = { 0x10, 0x04, 4 };
+            if((len == sizeof(request)) && !memcmp(buf, request, len)) asked = 1;
+            return MockStream::write(buf, len);
+        }
+        using MockStream::write;
+
+        int available() {
+            if(asked && (++asked > 5) && (answer >= 0)) {
+                reply((uint8_t)answer);
+                asked = 0;
+            }
+            return MockStream::available();
+        }
+
+    private:
+
+        int
+            answer,
+            asked;
+};
+
+static void testHasPaperWaits() {
+    // The first call waits for the printer's answer
+    PaperSensor empty(0x72), loaded(0x12);
+    ESC_POS_Printer emptyPrinter(&empty), loadedPrinter(&loaded);
+    CHECK(!emptyPrinter.hasPaper());
+    CHECK(loadedPrinter.hasPaper());
+
+    // Later calls answer at once from the last reply and ask again
+    CHECK(!emptyPrinter.hasPaper());
+    CHECK(empty.bytesWritten() == 6);
+
+    // A printer that never answers is taken to have paper once the
+    // request expires
+    PaperSensor silent(-1);
+    ESC_POS_Printer silentPrinter(&silent);
+    unsigned long start = millis();
+    CHECK(silentPrinter.hasPaper());
+    CHECK(millis() - start >= ESC_POS_STATUS_TIMEOUT);
+}
+
+int main() {
+    testAutomaticStatusBack();
+    testRealTimeStatus();
+    testStatusTimeout();
+    testHasPaperWaits();
+    return checkResult();
+}
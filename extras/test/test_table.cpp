@@ -0,0 +1,136 @@
+/*------------------------------------------------------------------------
+  Host tests of column layout: placement, word wrap, zero width columns
+  the justification left after a row and UTF-8 text.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "ESC_POS_Table.h"
+#include "MockStream.h"
+#include "Check.h"
+
+static const ESC_POS_Column itemColumns[] = {
+    { 10, 'L', true },
+    {  6, 'R', false }
+};
+
+static void testLayout() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    ESC_POS_Table table(itemColumns, 2);
+    const char *cells[] = { "Coffee beans", "12.50" };
+
+    CHECK(table.width() == 17);
+    printer.reset();
+    printer.commit();
+    out.clear();
+    table.printRow(printer, cells);
+    CHECK_BYTES(out.output(), 'C', 'o', 'f', 'f', 'e', 'e',
+            0x1B, '$', 12 * 12, 0, '1', '2', '.', '5', '0', '\n',
+            'b', 'e', 'a', 'n', 's', '\n');
+}
+
+static void testZeroWidth() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    static const ESC_POS_Column columns[] = {
+        { 0, 'L', true },
+        { 4, 'L', true }
+    };
+    ESC_POS_Table table(columns, 2);
+    const char *cells[] = { "hidden text", "shown text" };
+
+    // The empty column is left out instead of wrapping forever
+    printer.reset();
+    printer.commit();
+    out.clear();
+    table.printRow(printer, cells);
+    CHECK_BYTES(out.output(), 0x1B, '$', 12, 0, 's', 'h', 'o', 'w', '\n',
+            0x1B, '$', 12, 0, 'n', '\n',
+            0x1B, '$', 12, 0, 't', 'e', 'x', 't', '\n');
+}
+
+static void testJustification() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    ESC_POS_Table table(itemColumns, 2);
+    const char *cells[] = { "Tea", "2.00" };
+
+    // Rows are printed left justified and the caller's setting returns
+    printer.reset();
+    printer.justify('C');
+    CHECK(printer.justification() == 'C');
+    printer.commit();
+    out.clear();
+    table.printRow(printer, cells);
+    printer.commit();
+    const std::vector<uint8_t> &bytes = out.output();
+    CHECK((bytes.size() > 6) && (bytes[0] == 0x1B) && (bytes[1] == 'a') &&
+            (bytes[2] == 0));
+    static const uint8_t centre[] = { '\n', 0x1B, 'a', 1 };
+    CHECK((bytes.size() > 4) &&
+            !memcmp(&bytes[bytes.size() - 4], centre, sizeof(centre)));
+    CHECK(printer.justification() == 'C');
+
+    // Unknown justification stays left
+    printer.invalidateState();
+    CHECK(printer.justification() == 0);
+    table.printRow(printer, cells);
+    CHECK(printer.justification() == 'L');
+}
+
+// Sends UTF-8 on unchanged, so the bytes placed can be checked
+class PassThrough : public ESC_POS_Encoder {
+
+    public:
+
+        void write(ESC_POS_Printer &printer, const uint8_t *text, size_t len) {
+            printer.write(text, len);
+        }
+};
+
+static void testUtf8() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    PassThrough encoder;
+    static const ESC_POS_Column columns[] = {
+        { 6, 'L', true },
+        { 5, 'R', false },
+        { 3, 'L', true }
+    };
+    ESC_POS_Table table(columns, 3);
+    const char *cells[] = {
+        "Caf\xC3\xA9 cr\xC3\xA8me", "Caf\xC3\xA9", "\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9"
+    };
+
+    // Characters, not bytes, fill columns, and a word too long for its
+    // column breaks between characters
+    printer.setEncoder(&encoder);
+    printer.reset();
+    printer.commit();
+    out.clear();
+    table.printRow(printer, cells);
+    CHECK_BYTES(out.output(), 'C', 'a', 'f', 0xC3, 0xA9,
+            0x1B, '$', 8 * 12, 0, 'C', 'a', 'f', 0xC3, 0xA9,
+            0x1B, '$', 13 * 12, 0, 0xC3, 0xA9, 0xC3, 0xA9, 0xC3, 0xA9, '\n',
+            'c', 'r', 0xC3, 0xA8, 'm', 'e',
+            0x1B, '$', 13 * 12, 0, 0xC3, 0xA9, '\n');
+
+    // Without an encoder each byte is a character of the code page
+    printer.setEncoder(NULL);
+    out.clear();
+    table.printRow(printer, cells);
+    CHECK_BYTES(out.output(), 'C', 'a', 'f', 0xC3, 0xA9,
+            0x1B, '$', 7 * 12, 0, 'C', 'a', 'f', 0xC3, 0xA9,
+            0x1B, '$', 13 * 12, 0, 0xC3, 0xA9, 0xC3, '\n',
+            'c', 'r', 0xC3, 0xA8, 'm', 'e',
+            0x1B, '$', 13 * 12, 0, 0xA9, 0xC3, 0xA9, '\n',
+            0x1B, '$', 13 * 12, 0, 0xC3, 0xA9, '\n');
+}
+
+int main() {
+    testLayout();
+    testZeroWidth();
+    testJustification();
+    testUtf8();
+    return checkResult();
+}
@@ -0,0 +1,75 @@
+/*------------------------------------------------------------------------
+  Host tests of receipt templates: fields and styles, and layouts that
+  are empty, wrong or too big for the buffer.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "ESC_POS_Template.h"
+#include "MockStream.h"
+#include "Check.h"
+
+static void testFields() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    uint8_t buffer[64];
+    ESC_POS_Template receipt(buffer, sizeof(buffer));
+    const char *fields[] = { "Tea", "2.50" };
+
+    printer.reset();
+    printer.commit();
+    out.clear();
+    CHECK(receipt.compile("{B}{0:6}{b}|{1:>6}|{{\n"));
+    CHECK(receipt.fieldCount() == 2);
+    CHECK(receipt.print(printer, fields, 2));
+    CHECK_BYTES(out.output(), 0x1B, 'E', 1, 'T', 'e', 'a', ' ', ' ', ' ',
+            0x1B, 'E', 0, '|', ' ', ' ', '2', '.', '5', '0', '|', '{', '\n');
+
+    // Missing fields print as blanks
+    out.clear();
+    CHECK(receipt.print(printer, fields, 1));
+    CHECK(out.bytesWritten() == 22);
+}
+
+static void testEmptyAndInvalid() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    uint8_t buffer[16];
+    ESC_POS_Template receipt(buffer, sizeof(buffer));
+
+    // Nothing compiled yet
+    CHECK(!receipt.print(printer, NULL, 0));
+
+    // An empty layout is a program that prints nothing
+    CHECK(receipt.compile(""));
+    CHECK(receipt.size() == 0);
+    CHECK(receipt.print(printer, NULL, 0));
+    CHECK(out.bytesWritten() == 0);
+
+    // A failed compile leaves nothing to print
+    CHECK(!receipt.compile("{X}"));
+    CHECK(!receipt.print(printer, NULL, 0));
+    CHECK(!receipt.compile("{0"));
+    CHECK(!receipt.compile("This layout does not fit"));
+    CHECK(!receipt.print(printer, NULL, 0));
+    CHECK(receipt.compile("Fits"));
+    CHECK(receipt.print(printer, NULL, 0));
+}
+
+static void testNoCapacity() {
+    uint8_t guard[2] = { 0xAA, 0xAA };
+    ESC_POS_Template none(guard, 0), one(guard, 1);
+
+    // Not even OP_END fits in no bytes; the buffer is left alone
+    CHECK(!none.compile(""));
+    CHECK(guard[0] == 0xAA);
+    CHECK(one.compile(""));
+    CHECK(!one.compile("x"));
+    CHECK(guard[1] == 0xAA);
+}
+
+int main() {
+    testFields();
+    testEmptyAndInvalid();
+    testNoCapacity();
+    return checkResult();
+}
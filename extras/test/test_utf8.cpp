@@ -0,0 +1,138 @@
+/*------------------------------------------------------------------------
+  Host tests of UTF-8 text: code page choice and switches, characters in
+  no page, and sequences split across writes.
+  ------------------------------------------------------------------------*/
+
+#include "ESC_POS_Printer.h"
+#include "ESC_POS_UTF8.h"
+#include "MockStream.h"
+#include "Check.h"
+
+// A printer on a known code page with nothing sent yet
+static void start(ESC_POS_Printer &printer, MockStream &out,
+        ESC_POS_UTF8 &encoder) {
+    printer.setEncoder(&encoder);
+    printer.reset();
+    printer.setCodePage(CODEPAGE_CP437);
+    printer.commit();
+    out.clear();
+}
+
+static void testPages() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    ESC_POS_UTF8 encoder;
+    start(printer, out, encoder);
+
+    // Already on CP437: no ESC t
+    printer.print("caf\xC3\xA9");
+    printer.commit();
+    CHECK_BYTES(out.output(), 'c', 'a', 'f', 0x82);
+
+    // Greek: alpha is in CP437 but beta and gamma are not, so the page
+    // goes to CP737, which has all three, at beta and stays there
+    out.clear();
+    printer.print("\xCE\xB1\xCE\xB2\xCE\xB3");
+    printer.commit();
+    CHECK_BYTES(out.output(), 0xE0, 0x1B, 't', CODEPAGE_CP737, 0x99, 0x9A);
+
+    // The euro sign is in CP858 and WCP1252; "é" after it decides for
+    // CP858, which comes first in the list and has both
+    out.clear();
+    printer.print("\xE2\x82\xAC\xC3\xA9");
+    printer.commit();
+    CHECK_BYTES(out.output(), 0x1B, 't', CODEPAGE_CP858, 0xD5, 0x82);
+
+    // Cyrillic is only in CP866 and WCP1251
+    out.clear();
+    printer.print("\xD0\x96");
+    printer.commit();
+    CHECK_BYTES(out.output(), 0x1B, 't', CODEPAGE_CP866, 0x86);
+}
+
+// Pages limited to the ones given
+static void testPageList() {
+    static const uint8_t latin[] = { CODEPAGE_WCP1252 };
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    ESC_POS_UTF8 encoder(latin, sizeof(latin));
+    start(printer, out, encoder);
+
+    printer.print("\xC3\xA9\xCE\xB2");
+    printer.commit();
+    CHECK_BYTES(out.output(), 0x1B, 't', CODEPAGE_WCP1252, 0xE9, '?');
+}
+
+// A glyph for the rightwards arrow, a code point in no page
+static const ESC_POS_Glyph arrow[] PROGMEM = {
+    { 0x2192, { 0 } }
+};
+
+static void testUnmappable() {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    ESC_POS_UTF8 encoder;
+    start(printer, out, encoder);
+
+    // No page has it, nor does any have U+10000 (four bytes), and bad
+    // bytes are replaced
+    printer.print("a\xE2\x86\x92" "b\xF0\x90\x80\x80" "c\xFF" "d");
+    printer.commit();
+    CHECK_BYTES(out.output(), 'a', '?', 'b', '?', 'c', '?', 'd');
+
+    // With a glyph it is drawn as a user-defined character, downloaded
+    // the first time only
+    encoder.setGlyphs(arrow, 1);
+    out.clear();
+    printer.print("\xE2\x86\x92\xE2\x86\x92");
+    printer.commit();
+    const std::vector<uint8_t> &bytes = out.output();
+    static const uint8_t define[] = { 0x1B, '&', 3, '!', '!', 12 };
+    static const uint8_t use[] = { 0x1B, '%', 1, '!', 0x1B, '%', 0 };
+    CHECK(bytes.size() == sizeof(define) + 36 + 2 * sizeof(use));
+    CHECK(contains(bytes, define, sizeof(define)));
+    CHECK(!memcmp(&bytes[bytes.size() - 2 * sizeof(use)], use, sizeof(use)));
+    CHECK(!memcmp(&bytes[bytes.size() - sizeof(use)], use, sizeof(use)));
+}
+
+// Text written in pieces of at most step bytes, the first one cut bytes
+// long, to a new printer and encoder
+static std::vector<uint8_t> pieces(const char *text, size_t cut, size_t step) {
+    MockStream out;
+    ESC_POS_Printer printer(&out);
+    ESC_POS_UTF8 encoder;
+    size_t len = strlen(text);
+    start(printer, out, encoder);
+    for(size_t i = 0, n = cut; i < len; i += n, n = step) {
+        printer.write((const uint8_t *)text + i, min(n, len - i));
+    }
+    printer.commit();
+    return out.output();
+}
+
+// Characters cut between write() calls come out the same as whole ones.
+// Lookahead stops at the end of a write, so the text is one where it
+// does not change the pages chosen.
+static void testSplit() {
+    static const char text[] =
+        "Gr\xC3\xBC\xC3\x9F" "e \xE2\x82\xAC" "5 caf\xC3\xA9";
+    std::vector<uint8_t> whole = pieces(text, sizeof(text), sizeof(text));
+
+    CHECK_BYTES(whole, 'G', 'r', 0x81, 0xE1, 'e', ' ',
+            0x1B, 't', CODEPAGE_CP858, 0xD5, '5', ' ', 'c', 'a', 'f', 0x82);
+    for(size_t cut = 1; cut < sizeof(text) - 1; cut++) {
+        CHECK(pieces(text, cut, sizeof(text)) == whole);
+    }
+    CHECK(pieces(text, 1, 1) == whole);
+
+    // A sequence cut short by another character is one '?'
+    CHECK_BYTES(pieces("\xC3" "A", 1, 1), '?', 'A');
+}
+
+int main() {
+    testPages();
+    testPageList();
+    testUnmappable();
+    testSplit();
+    return checkResult();
+}